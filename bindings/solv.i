@@ -1041,6 +1041,15 @@ typedef struct {
     return q;
   }
 
+  %typemap(out) Queue whatmatchesdep Queue2Array(XSolvable *, 1, new_XSolvable(arg1, id));
+  %newobject whatmatchesdep;
+  Queue whatmatchesdep(Id keyname, Id dep) {
+    Queue q;
+    queue_init(&q);
+    pool_whatmatchesdep($self, keyname, dep, &q);
+    return q;
+  }
+
   Id towhatprovides(Queue q) {
     return pool_queuetowhatprovides($self, &q);
   }
@@ -2140,6 +2149,11 @@ typedef struct {
   static const int SOLVER_FLAG_IGNORE_RECOMMENDED = SOLVER_FLAG_IGNORE_RECOMMENDED;
   static const int SOLVER_FLAG_ADD_ALREADY_RECOMMENDED = SOLVER_FLAG_ADD_ALREADY_RECOMMENDED;
   static const int SOLVER_FLAG_NO_INFARCHCHECK = SOLVER_FLAG_NO_INFARCHCHECK;
+  static const int SOLVER_FLAG_ACTIVITY_HEURISTIC = SOLVER_FLAG_ACTIVITY_HEURISTIC;
+
+  static const int SOLVER_BUDGET_PROPAGATIONS = SOLVER_BUDGET_PROPAGATIONS;
+  static const int SOLVER_BUDGET_CONFLICTS = SOLVER_BUDGET_CONFLICTS;
+  static const int SOLVER_BUDGET_TIME = SOLVER_BUDGET_TIME;
 
   ~Solver() {
     solver_free($self);
@@ -2151,6 +2165,15 @@ typedef struct {
   int get_flag(int flag) {
     return solver_get_flag($self, flag);
   }
+  int set_budget(int budget, int value) {
+    return solver_set_budget($self, budget, value);
+  }
+  int get_budget(int budget) {
+    return solver_get_budget($self, budget);
+  }
+  bool aborted() {
+    return solver_aborted($self);
+  }
 #if defined(SWIGPYTHON)
   %pythoncode {
     def solve(self, jobs):
@@ -2197,6 +2220,15 @@ rb_eval_string(
   Transaction *transaction() {
     return solver_create_transaction($self);
   }
+
+  %typemap(out) Queue updatecandidates Queue2Array(XSolvable *, 1, new_XSolvable(arg1->pool, id));
+  %newobject updatecandidates;
+  Queue updatecandidates(XSolvable *s, int allow_all = 0) {
+    Queue q;
+    queue_init(&q);
+    policy_findupdatepackages($self, $self->pool->solvables + s->id, &q, allow_all);
+    return q;
+  }
 }
 
 %extend Transaction {
@@ -2438,6 +2470,9 @@ rb_eval_string(
   void create_stubs() {
     repodata_create_stubs(repo_id2repodata($self->repo, $self->id));
   }
+  void create_keycolumn(Id keyname) {
+    repodata_create_keycolumn(repo_id2repodata($self->repo, $self->id), keyname);
+  }
   void write(FILE *fp) {
     repodata_write(repo_id2repodata($self->repo, $self->id), fp);
   }
@@ -90,6 +90,7 @@ static struct solverflags2str {
   { SOLVER_FLAG_IGNORE_RECOMMENDED,         "ignorerecommended", 0 },
   { SOLVER_FLAG_ADD_ALREADY_RECOMMENDED,    "addalreadyrecommended", 0 },
   { SOLVER_FLAG_NO_INFARCHCHECK,            "noinfarchcheck", 0 },
+  { SOLVER_FLAG_ACTIVITY_HEURISTIC,         "activityheuristic", 0 },
   { 0, 0, 0 }
 };
 
@@ -821,6 +822,7 @@ writedeps(Repo *repo, FILE *fp, const char *tag, Id key, Solvable *s, Offset off
 	    }
 	  fprintf(fp, "%s\n", s);
 	}
+      dataiterator_free(&di);
     }
   if (tagwritten)
     fprintf(fp, "-%s\n", tag);
@@ -59,16 +59,155 @@ map_grow(Map *m, int n)
     }
 }
 
+/*
+ * the map operations below work on whole words. The maps are byte
+ * arrays of any length, so the words are accessed with memcpy and the
+ * remaining bytes are done one by one.
+ */
+typedef unsigned long MapWord;
+
+#define MAPWORDSIZE ((int)sizeof(MapWord))
+
+static inline int
+map_bytectz(unsigned int b)
+{
+#if defined(__GNUC__)
+  return __builtin_ctz(b);
+#else
+  int n = 0;
+  for (; !(b & 1); b >>= 1)
+    n++;
+  return n;
+#endif
+}
+
+static inline int
+map_wordpopcount(MapWord w)
+{
+#if defined(__GNUC__)
+  return __builtin_popcountl(w);
+#else
+  int n = 0;
+  for (; w; w &= w - 1)
+    n++;
+  return n;
+#endif
+}
+
 /* bitwise-ands same-sized maps t and s, stores the result in t. */
 void
 map_and(Map *t, Map *s)
 {
-    unsigned char *ti, *si, *end;
-    ti = t->map;
-    si = s->map;
-    end = ti + t->size;
-    while (ti < end)
-	*ti++ &= *si++;
+  unsigned char *ti, *si, *end;
+  MapWord tw, sw;
+  ti = t->map;
+  si = s->map;
+  end = ti + t->size;
+  for (; ti + MAPWORDSIZE <= end; ti += MAPWORDSIZE, si += MAPWORDSIZE)
+    {
+      memcpy(&tw, ti, MAPWORDSIZE);
+      memcpy(&sw, si, MAPWORDSIZE);
+      tw &= sw;
+      memcpy(ti, &tw, MAPWORDSIZE);
+    }
+  while (ti < end)
+    *ti++ &= *si++;
+}
+
+/* bitwise-ors maps t and s, stores the result in t. t is grown
+ * if it is smaller than s. */
+void
+map_or(Map *t, Map *s)
+{
+  unsigned char *ti, *si, *end;
+  MapWord tw, sw;
+  if (t->size < s->size)
+    map_grow(t, s->size << 3);
+  ti = t->map;
+  si = s->map;
+  end = ti + s->size;
+  for (; ti + MAPWORDSIZE <= end; ti += MAPWORDSIZE, si += MAPWORDSIZE)
+    {
+      memcpy(&tw, ti, MAPWORDSIZE);
+      memcpy(&sw, si, MAPWORDSIZE);
+      tw |= sw;
+      memcpy(ti, &tw, MAPWORDSIZE);
+    }
+  while (ti < end)
+    *ti++ |= *si++;
+}
+
+/* clears all bits in t that are set in s (t = t & ~s) */
+void
+map_subtract(Map *t, Map *s)
+{
+  unsigned char *ti, *si, *end;
+  MapWord tw, sw;
+  ti = t->map;
+  si = s->map;
+  end = ti + (t->size < s->size ? t->size : s->size);
+  for (; ti + MAPWORDSIZE <= end; ti += MAPWORDSIZE, si += MAPWORDSIZE)
+    {
+      memcpy(&tw, ti, MAPWORDSIZE);
+      memcpy(&sw, si, MAPWORDSIZE);
+      tw &= ~sw;
+      memcpy(ti, &tw, MAPWORDSIZE);
+    }
+  while (ti < end)
+    *ti++ &= ~*si++;
+}
+
+/* returns the number of set bits */
+int
+map_count(Map *m)
+{
+  unsigned char *mi, *end;
+  MapWord w;
+  int n = 0;
+  mi = m->map;
+  end = mi + m->size;
+  for (; mi + MAPWORDSIZE <= end; mi += MAPWORDSIZE)
+    {
+      memcpy(&w, mi, MAPWORDSIZE);
+      if (w)
+	n += map_wordpopcount(w);
+    }
+  for (; mi < end; mi++)
+    if (*mi)
+      n += map_wordpopcount(*mi);
+  return n;
+}
+
+/* returns the first set bit that is not smaller than n, or -1 if
+ * there is none. Use it to iterate over sparse maps:
+ *   for (p = map_next(m, 0); p >= 0; p = map_next(m, p + 1))
+ */
+int
+map_next(Map *m, int n)
+{
+  unsigned char *mi, *end;
+  MapWord w;
+  unsigned int b;
+
+  if (n < 0)
+    n = 0;
+  if ((n >> 3) >= m->size)
+    return -1;
+  mi = m->map + (n >> 3);
+  b = *mi & (0xff << (n & 7));
+  if (b)
+    return ((mi - m->map) << 3) + map_bytectz(b);
+  end = m->map + m->size;
+  for (mi++; mi + MAPWORDSIZE <= end; mi += MAPWORDSIZE)
+    {
+      memcpy(&w, mi, MAPWORDSIZE);
+      if (w)
+	break;
+    }
+  for (; mi < end; mi++)
+    if (*mi)
+      return ((mi - m->map) << 3) + map_bytectz(*mi);
+  return -1;
 }
 
 /* EOF */
@@ -35,6 +35,10 @@ extern void map_init_clone(Map *t, Map *s);
 extern void map_grow(Map *m, int n);
 extern void map_free(Map *m);
 extern void map_and(Map *t, Map *s);
+extern void map_or(Map *t, Map *s);
+extern void map_subtract(Map *t, Map *s);
+extern int map_count(Map *m);
+extern int map_next(Map *m, int n);
 
 static inline void map_empty(Map *m)
 {
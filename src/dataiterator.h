@@ -71,6 +71,9 @@ typedef struct _Datamatcher {
   int error;
 } Datamatcher;
 
+/* datamatcher_init allocates the match data for all string match
+ * modes, not just for regexes, so every matcher must be released with
+ * datamatcher_free. Freeing a matcher whose init failed is harmless. */
 int  datamatcher_init(Datamatcher *ma, const char *match, int flags);
 void datamatcher_free(Datamatcher *ma);
 int  datamatcher_match(Datamatcher *ma, const char *str);
@@ -62,6 +62,15 @@
  * to find all children of dirid 3 ("/usr"), follow the
  * dirtraverse link to 12 -> "games". Then follow the
  * dirtraverse link of this block to 5 -> "bin", "lib"
+ *
+ * When it adds dirs, dirpool_add_dir also creates the aux
+ * "dirparents" array that maps every id to its parent
+ * directory, and a hash (parent, comp) -> id, so that it
+ * does not need to search the blocks. Both can be freed with
+ * dirpool_free_dirhash. Lookups without the create flag do
+ * not create them, they search the blocks of the parent if
+ * there is no hash. dirpool_parent falls back to searching
+ * the block start.
  */
 
 void
@@ -75,6 +84,38 @@ dirpool_free(Dirpool *dp)
 {
   solv_free(dp->dirs);
   solv_free(dp->dirtraverse);
+  solv_free(dp->dirparents);
+  solv_free(dp->dirhashtbl);
+}
+
+static inline Hashval
+dirhash(Id parent, Id comp)
+{
+  return (Hashval)parent * 31 + (Hashval)comp * 0x9e3779b1;
+}
+
+static void
+dirpool_rehash(Dirpool *dp)
+{
+  Hashval h, hh;
+  Hashmask hashmask;
+  Id d, parent;
+
+  hashmask = mkmask(dp->ndirs + DIR_BLOCK);
+  solv_free(dp->dirhashtbl);
+  dp->dirhashtbl = solv_calloc(hashmask + 1, sizeof(Id));
+  dp->dirhashmask = hashmask;
+  for (d = 2; d < dp->ndirs; d++)
+    {
+      if (dp->dirs[d] <= 0)
+	continue;
+      parent = dp->dirparents[d];
+      h = dirhash(parent, dp->dirs[d]) & hashmask;
+      hh = HASHCHAIN_START;
+      while (dp->dirhashtbl[h])
+	h = HASHCHAIN_NEXT(h, hh, hashmask);
+      dp->dirhashtbl[h] = d;
+    }
 }
 
 void
@@ -96,10 +137,52 @@ dirpool_make_dirtraverse(Dirpool *dp)
   dp->dirtraverse = dirtraverse;
 }
 
+static void
+dirpool_make_dirhash(Dirpool *dp)
+{
+  Id parent, i, *dirparents;
+
+  dirparents = solv_extend_resize(0, dp->ndirs, sizeof(Id), DIR_BLOCK);
+  for (parent = 0, i = 0; i < dp->ndirs; i++)
+    {
+      if (dp->dirs[i] <= 0)
+	parent = -dp->dirs[i];
+      dirparents[i] = parent;
+    }
+  solv_free(dp->dirparents);
+  dp->dirparents = dirparents;
+  dirpool_rehash(dp);
+}
+
+/* search all blocks of the parent for comp */
+static Id
+dirpool_find_dir(Dirpool *dp, Id parent, Id comp)
+{
+  Id d, ds;
+
+  ds = dp->dirtraverse[parent];
+  while (ds)
+    {
+      /* ds: first component in this block
+       * ds-1: parent link */
+      for (d = ds--; d < dp->ndirs; d++)
+	{
+	  if (dp->dirs[d] == comp)
+	    return d;
+	  if (dp->dirs[d] <= 0)	/* reached end of this block */
+	    break;
+	}
+      if (ds)
+	ds = dp->dirtraverse[ds];
+    }
+  return 0;
+}
+
 Id
 dirpool_add_dir(Dirpool *dp, Id parent, Id comp, int create)
 {
-  Id did, d, ds, *dirtraverse;
+  Id d;
+  Hashval h, hh;
 
   if (!dp->ndirs)
     {
@@ -114,44 +197,54 @@ dirpool_add_dir(Dirpool *dp, Id parent, Id comp, int create)
     return 1;
   if (!dp->dirtraverse)
     dirpool_make_dirtraverse(dp);
-  /* check all entries with this parent if we
-   * already have this component */
-  dirtraverse = dp->dirtraverse;
-  ds = dirtraverse[parent];
-  while (ds)
+  if (!dp->dirhashtbl)
     {
-      /* ds: first component in this block
-       * ds-1: parent link */
-      for (d = ds--; d < dp->ndirs; d++)
-	{
-	  if (dp->dirs[d] == comp)
-	    return d;
-	  if (dp->dirs[d] <= 0)	/* reached end of this block */
-	    break;
-	}
-      if (ds)
-        ds = dp->dirtraverse[ds];
+      /* read-only lookups do not need the hash */
+      if (!create)
+	return dirpool_find_dir(dp, parent, comp);
+      dirpool_make_dirhash(dp);
+    }
+  /* check if we already have this component */
+  h = dirhash(parent, comp) & dp->dirhashmask;
+  hh = HASHCHAIN_START;
+  while ((d = dp->dirhashtbl[h]) != 0)
+    {
+      if (dp->dirs[d] == comp && dp->dirparents[d] == parent)
+	return d;
+      h = HASHCHAIN_NEXT(h, hh, dp->dirhashmask);
     }
   if (!create)
     return 0;
-  /* a new one, find last parent */
-  for (did = dp->ndirs - 1; did > 0; did--)
-    if (dp->dirs[did] <= 0)
-      break;
-  if (dp->dirs[did] != -parent)
+  /* a new one, check if the last block has the same parent */
+  d = dp->ndirs - 1;
+  if (dp->dirs[d] <= 0 || dp->dirparents[d] != parent)
     {
       /* make room for parent entry */
       dp->dirs = solv_extend(dp->dirs, dp->ndirs, 1, sizeof(Id), DIR_BLOCK);
       dp->dirtraverse = solv_extend(dp->dirtraverse, dp->ndirs, 1, sizeof(Id), DIR_BLOCK);
+      dp->dirparents = solv_extend(dp->dirparents, dp->ndirs, 1, sizeof(Id), DIR_BLOCK);
       /* new parent block, link in */
       dp->dirs[dp->ndirs] = -parent;
+      dp->dirparents[dp->ndirs] = parent;
       dp->dirtraverse[dp->ndirs] = dp->dirtraverse[parent];
       dp->dirtraverse[parent] = ++dp->ndirs;
     }
   /* make room for new entry */
   dp->dirs = solv_extend(dp->dirs, dp->ndirs, 1, sizeof(Id), DIR_BLOCK);
   dp->dirtraverse = solv_extend(dp->dirtraverse, dp->ndirs, 1, sizeof(Id), DIR_BLOCK);
-  dp->dirs[dp->ndirs] = comp;
-  dp->dirtraverse[dp->ndirs] = 0;
-  return dp->ndirs++;
+  dp->dirparents = solv_extend(dp->dirparents, dp->ndirs, 1, sizeof(Id), DIR_BLOCK);
+  d = dp->ndirs++;
+  dp->dirs[d] = comp;
+  dp->dirparents[d] = parent;
+  dp->dirtraverse[d] = 0;
+  /* add it to the hash */
+  if ((Hashval)dp->ndirs * 2 > dp->dirhashmask)
+    dirpool_rehash(dp);
+  else
+    {
+      while (dp->dirhashtbl[h])
+	h = HASHCHAIN_NEXT(h, hh, dp->dirhashmask);
+      dp->dirhashtbl[h] = d;
+    }
+  return d;
 }
@@ -10,11 +10,15 @@
 
 #include "pooltypes.h"
 #include "util.h"
+#include "hash.h"
 
 typedef struct _Dirpool {
   Id *dirs;
   int ndirs;
   Id *dirtraverse;
+  Id *dirparents;		/* aux: dir -> parent dir */
+  Hashtable dirhashtbl;		/* aux: (parent, comp) -> dir */
+  Hashmask dirhashmask;
 } Dirpool;
 
 void dirpool_init(Dirpool *dp);
@@ -28,6 +32,8 @@ static inline Id dirpool_parent(Dirpool *dp, Id did)
 {
   if (!did)
     return 0;
+  if (dp->dirparents)
+    return dp->dirparents[did];
   while (dp->dirs[--did] > 0)
     ;
   return -dp->dirs[did];
@@ -68,6 +74,17 @@ dirpool_free_dirtraverse(Dirpool *dp)
   dp->dirtraverse = 0;
 }
 
+/* free the lookup data created by dirpool_add_dir */
+static inline void
+dirpool_free_dirhash(Dirpool *dp)
+{
+  solv_free(dp->dirparents);
+  dp->dirparents = 0;
+  solv_free(dp->dirhashtbl);
+  dp->dirhashtbl = 0;
+  dp->dirhashmask = 0;
+}
+
 static inline Id
 dirpool_compid(Dirpool *dp, Id did)
 {
@@ -22,6 +22,8 @@
 #include "poolvendor.h"
 #include "poolarch.h"
 
+#define UPDATECANDS_BLOCK 1023
+
 
 /*-----------------------------------------------------------------*/
 
@@ -110,10 +112,11 @@ static void
 prune_to_highest_prio_per_name(Pool *pool, Queue *plist)
 {
   Queue pq;
+  Id pqbuf[16];
   int i, j, k;
   Id name;
 
-  queue_init(&pq);
+  queue_init_buffer(&pq, pqbuf, sizeof(pqbuf)/sizeof(*pqbuf));
   solv_sort(plist->elements, plist->count, sizeof(Id), prune_to_best_version_sortcmp, pool);
   queue_push(&pq, plist->elements[0]);
   name = pool->solvables[pq.elements[0]].name;
@@ -763,20 +766,34 @@ policy_is_illegal(Solver *solv, Solvable *is, Solvable *s, int ignore)
  * For each installed solvable find which packages with *different* names
  * obsolete the solvable.
  * This index is used in policy_findupdatepackages() below.
+ *
+ * The index only depends on the pool, so it is created once and kept
+ * in the pool until whatprovides gets freed. Every solver gets its own
+ * copy, as the pool may drop the index while the solver is still alive.
+ * A solver with a different installed repo than the pool builds its own.
  */
-void
-policy_create_obsolete_index(Solver *solv)
+static int
+obsolete_index_valid(Pool *pool)
+{
+  if (!pool->obsoletes || pool->obsoletes_nsolvables != pool->nsolvables)
+    return 0;
+  if (!pool->considered)
+    return pool->obsoletes_considered.size == 0;
+  if (pool->obsoletes_considered.size != pool->considered->size)
+    return 0;
+  return memcmp(pool->obsoletes_considered.map, pool->considered->map, pool->considered->size) == 0;
+}
+
+/* returns the size of the obsoletes data */
+static int
+create_obsolete_index(Pool *pool, Repo *installed, Id **obsoletesp, Id **obsoletes_datap)
 {
-  Pool *pool = solv->pool;
   Solvable *s;
-  Repo *installed = solv->installed;
   Id p, pp, obs, *obsp, *obsoletes, *obsoletes_data;
   int i, n, cnt;
 
-  if (!installed || installed->start == installed->end)
-    return;
   cnt = installed->end - installed->start;
-  solv->obsoletes = obsoletes = solv_calloc(cnt, sizeof(Id));
+  *obsoletesp = obsoletes = solv_calloc(cnt, sizeof(Id));
   for (i = 1; i < pool->nsolvables; i++)
     {
       s = pool->solvables + i;
@@ -809,7 +826,7 @@ policy_create_obsolete_index(Solver *solv)
         n += obsoletes[i] + 1;
         obsoletes[i] = n;
       }
-  solv->obsoletes_data = obsoletes_data = solv_calloc(n + 1, sizeof(Id));
+  *obsoletes_datap = obsoletes_data = solv_calloc(n + 1, sizeof(Id));
   POOL_DEBUG(SOLV_DEBUG_STATS, "obsoletes data: %d entries\n", n + 1);
   for (i = pool->nsolvables - 1; i > 0; i--)
     {
@@ -837,45 +854,54 @@ policy_create_obsolete_index(Solver *solv)
 	    }
 	}
     }
+  return n + 1;
+}
+
+void
+policy_create_obsolete_index(Solver *solv)
+{
+  Pool *pool = solv->pool;
+  Repo *installed = solv->installed;
+  int cnt;
+
+  if (!installed || installed->start == installed->end)
+    return;
+  if (installed != pool->installed)
+    {
+      create_obsolete_index(pool, installed, &solv->obsoletes, &solv->obsoletes_data);
+      return;
+    }
+  if (!obsolete_index_valid(pool))
+    {
+      solv_free(pool->obsoletes);
+      solv_free(pool->obsoletes_data);
+      map_free(&pool->obsoletes_considered);
+      pool->obsoletes_datasize = create_obsolete_index(pool, installed, &pool->obsoletes, &pool->obsoletes_data);
+      pool->obsoletes_nsolvables = pool->nsolvables;
+      if (pool->considered)
+	map_init_clone(&pool->obsoletes_considered, pool->considered);
+      pool->obsoletes_generation++;
+      /* the cached update candidates were made with the old index */
+      pool_freeupdatecandidates(pool);
+    }
+  solv->obsoletes_generation = pool->obsoletes_generation;
+  cnt = installed->end - installed->start;
+  solv->obsoletes = solv_memdup2(pool->obsoletes, cnt, sizeof(Id));
+  solv->obsoletes_data = solv_memdup2(pool->obsoletes_data, pool->obsoletes_datasize, sizeof(Id));
 }
 
 
 /*
- * find update candidates
- * 
- * s: installed solvable to be updated
- * qs: [out] queue to hold Ids of candidates
- * allow_all: 0 = dont allow downgrades, 1 = allow all candidates
- *            2 = dup mode
- * 
+ * find update candidates, see policy_findupdatepackages()
  */
-void
-policy_findupdatepackages(Solver *solv, Solvable *s, Queue *qs, int allow_all)
+static void
+findupdatepackages(Solver *solv, Solvable *s, Queue *qs, int allowdowngrade, int allownamechange, int allowarchchange, int allowvendorchange)
 {
-  /* installed packages get a special upgrade allowed rule */
   Pool *pool = solv->pool;
   Id p, pp, n, p2, pp2;
   Id obs, *obsp;
   Solvable *ps;
   int haveprovobs = 0;
-  int allowdowngrade = allow_all ? 1 : solv->allowdowngrade;
-  int allownamechange = allow_all ? 1 : solv->allownamechange;
-  int allowarchchange = allow_all ? 1 : solv->allowarchchange;
-  int allowvendorchange = allow_all ? 1 : solv->allowvendorchange;
-  if (allow_all == 2)
-    {
-      allowdowngrade = solv->dup_allowdowngrade;
-      allownamechange = solv->dup_allownamechange;
-      allowarchchange = solv->dup_allowarchchange;
-      allowvendorchange = solv->dup_allowvendorchange;
-    }
-
-  queue_empty(qs);
-
-  if (solv && solv->updateCandidateCb)
-    { /* The application is responsible for */
-      return solv->updateCandidateCb(solv->pool, s, qs);
-    }
 
   n = s - pool->solvables;
 
@@ -949,3 +975,81 @@ policy_findupdatepackages(Solver *solv, Solvable *s, Queue *qs, int allow_all)
     }
 }
 
+/*
+ * find update candidates
+ * 
+ * s: installed solvable to be updated
+ * qs: [out] queue to hold Ids of candidates
+ * allow_all: 0 = dont allow downgrades, 1 = allow all candidates
+ *            2 = dup mode
+ * 
+ * The candidates of installed packages only depend on the pool, the
+ * obsoletes index and the allow flags, so they are cached in the pool.
+ * The cache is freed together with whatprovides and whenever the
+ * obsoletes index is recreated, e.g. because pool->considered changed.
+ */
+void
+policy_findupdatepackages(Solver *solv, Solvable *s, Queue *qs, int allow_all)
+{
+  /* installed packages get a special upgrade allowed rule */
+  Pool *pool = solv->pool;
+  Repo *installed = solv->installed;
+  Id k, off, *cp;
+  int allowdowngrade = allow_all ? 1 : solv->allowdowngrade;
+  int allownamechange = allow_all ? 1 : solv->allownamechange;
+  int allowarchchange = allow_all ? 1 : solv->allowarchchange;
+  int allowvendorchange = allow_all ? 1 : solv->allowvendorchange;
+  if (allow_all == 2)
+    {
+      allowdowngrade = solv->dup_allowdowngrade;
+      allownamechange = solv->dup_allownamechange;
+      allowarchchange = solv->dup_allowarchchange;
+      allowvendorchange = solv->dup_allowvendorchange;
+    }
+
+  queue_empty(qs);
+
+  if (solv && solv->updateCandidateCb)
+    { /* The application is responsible for */
+      return solv->updateCandidateCb(solv->pool, s, qs);
+    }
+
+  /* the obsoletes index is created when solving starts, don't cache the
+   * candidates without it or if the pool has a newer one */
+  if (!installed || s->repo != installed || installed != pool->installed || !solv->obsoletes || solv->obsoletes_generation != pool->obsoletes_generation || solv->archCheckCb || solv->vendorCheckCb)
+    {
+      findupdatepackages(solv, s, qs, allowdowngrade, allownamechange, allowarchchange, allowvendorchange);
+      return;
+    }
+  if (pool->updatecandsnsolvables != pool->nsolvables)
+    {
+      pool_freeupdatecandidates(pool);
+      pool->updatecandsnsolvables = pool->nsolvables;
+    }
+  k = (allowdowngrade ? 1 : 0) | (allownamechange ? 2 : 0) | (allowarchchange ? 4 : 0) | (allowvendorchange ? 8 : 0) | (solv->noupdateprovide ? 16 : 0);
+  if (!pool->updatecands[k])
+    pool->updatecands[k] = solv_calloc(installed->end - installed->start, sizeof(Offset));
+  off = pool->updatecands[k][s - pool->solvables - installed->start];
+  if (off)
+    {
+      for (cp = pool->updatecandsdata + off; *cp; cp++)
+	queue_push(qs, *cp);
+      return;
+    }
+  findupdatepackages(solv, s, qs, allowdowngrade, allownamechange, allowarchchange, allowvendorchange);
+  if (!pool->updatecandsdatalen)
+    {
+      /* offset 0 means not computed */
+      pool->updatecandsdata = solv_extend_resize(pool->updatecandsdata, 1, sizeof(Id), UPDATECANDS_BLOCK);
+      pool->updatecandsdata[0] = 0;
+      pool->updatecandsdatalen = 1;
+    }
+  off = pool->updatecandsdatalen;
+  pool->updatecandsdata = solv_extend(pool->updatecandsdata, off, qs->count + 1, sizeof(Id), UPDATECANDS_BLOCK);
+  if (qs->count)
+    memcpy(pool->updatecandsdata + off, qs->elements, qs->count * sizeof(Id));
+  pool->updatecandsdata[off + qs->count] = 0;
+  pool->updatecandsdatalen = off + qs->count + 1;
+  pool->updatecands[k][s - pool->solvables - installed->start] = off;
+}
+
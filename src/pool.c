@@ -79,6 +79,17 @@ pool_create(void)
 }
 
 
+static void
+pool_freeobsoleteindex(Pool *pool)
+{
+  pool->obsoletes = solv_free(pool->obsoletes);
+  pool->obsoletes_data = solv_free(pool->obsoletes_data);
+  pool->obsoletes_datasize = 0;
+  pool->obsoletes_nsolvables = 0;
+  map_free(&pool->obsoletes_considered);
+  pool->obsoletes_generation++;
+}
+
 /* free all the resources of our pool */
 void
 pool_free(Pool *pool)
@@ -125,6 +136,7 @@ void
 pool_setdisttype(Pool *pool, int disttype)
 {
   pool->disttype = disttype;
+  pool_freeupdatecandidates(pool);
 }
 #endif
 
@@ -183,6 +195,14 @@ pool_set_flag(Pool *pool, int flag, int value)
     default:
       break;
     }
+  if (old != value)
+    {
+      /* drop the cached data that depends on the flag */
+      if (flag == POOL_FLAG_OBSOLETEUSESPROVIDES || flag == POOL_FLAG_OBSOLETEUSESCOLORS)
+	pool_freeobsoleteindex(pool);
+      if (flag == POOL_FLAG_OBSOLETEUSESPROVIDES || flag == POOL_FLAG_OBSOLETEUSESCOLORS || flag == POOL_FLAG_PROMOTEEPOCH || flag == POOL_FLAG_HAVEDISTEPOCH)
+	pool_freeupdatecandidates(pool);
+    }
   return old;
 }
 
@@ -463,6 +483,226 @@ pool_freewhatprovides(Pool *pool)
   pool->whatprovidesdata = solv_free(pool->whatprovidesdata);
   pool->whatprovidesdataoff = 0;
   pool->whatprovidesdataleft = 0;
+  pool_freewhatdeps(pool);
+  pool_freeobsoleteindex(pool);
+  pool_freeupdatecandidates(pool);
+}
+
+
+/******************************************************************************/
+
+/*
+ * reverse dependency index
+ *
+ * For every name we store the solvables that have a dependency of a
+ * specific type (requires, recommends, supplements, enhances) mentioning
+ * the name.
+ * Relations are reduced to their names, both sides of AND/OR/WITH
+ * relations are indexed. Dependencies that cannot be reduced to a
+ * name (namespaces, file conflicts, ...) are stored under name 0.
+ * Thus the index returns a superset of the packages with a matching
+ * dependency, the caller has to check the dependencies itself.
+ * Like the whatprovides data only installed and installable solvables
+ * are indexed. The index is freed with the whatprovides data.
+ */
+
+static inline int
+whatdeps_slot(Id keyname)
+{
+  switch (keyname)
+    {
+    case SOLVABLE_REQUIRES:
+      return 0;
+    case SOLVABLE_RECOMMENDS:
+      return 1;
+    case SOLVABLE_SUPPLEMENTS:
+      return 2;
+    case SOLVABLE_ENHANCES:
+      return 3;
+    default:
+      return -1;
+    }
+}
+
+static inline Offset
+whatdeps_solvable_deps(Solvable *s, Id keyname)
+{
+  switch (keyname)
+    {
+    case SOLVABLE_REQUIRES:
+      return s->requires;
+    case SOLVABLE_RECOMMENDS:
+      return s->recommends;
+    case SOLVABLE_SUPPLEMENTS:
+      return s->supplements;
+    case SOLVABLE_ENHANCES:
+      return s->enhances;
+    default:
+      return 0;
+    }
+}
+
+/* count (data == 0) or store the entries for dep */
+static void
+whatdeps_adddep(Pool *pool, Id dep, Offset *whatdeps, Id *data, Id p)
+{
+  Id *d;
+
+  while (ISRELDEP(dep))
+    {
+      Reldep *rd = GETRELDEP(pool, dep);
+      if (rd->flags == REL_AND || rd->flags == REL_OR || rd->flags == REL_WITH)
+	{
+	  whatdeps_adddep(pool, rd->name, whatdeps, data, p);
+	  dep = rd->evr;
+	}
+      else if (rd->flags < 8 || rd->flags == REL_ARCH)
+	dep = rd->name;
+      else
+	dep = 0;	/* not indexable */
+    }
+  if (!data)
+    {
+      whatdeps[dep]++;
+      return;
+    }
+  d = data + whatdeps[dep];
+  if (*d != p)		/* don't add same solvable twice */
+    {
+      d[-1] = p;
+      whatdeps[dep]--;
+    }
+}
+
+static void
+pool_createwhatdeps(Pool *pool, int k, Id keyname)
+{
+  Repo *installed = pool->installed;
+  Offset *whatdeps, off, n;
+  Id *whatdepsdata = 0;
+  Id i, dep, *dp;
+  Solvable *s;
+  int pass, num = pool->ss.nstrings;
+  unsigned int now;
+
+  now = solv_timems(0);
+  whatdeps = solv_calloc(num, sizeof(Offset));
+  for (pass = 0; pass < 2; pass++)
+    {
+      if (pass)
+	{
+	  off = 1;	/* first entry is the empty list */
+	  for (i = 0; i < num; i++)
+	    {
+	      if (!(n = whatdeps[i]))
+		continue;
+	      off += n;
+	      whatdeps[i] = off++;	/* points to terminating zero */
+	    }
+	  whatdepsdata = solv_calloc(off, sizeof(Id));
+	}
+      for (i = pool->nsolvables - 1; i > 0; i--)
+	{
+	  s = pool->solvables + i;
+	  if (!s->repo || s->repo->disabled)
+	    continue;
+	  if (s->repo != installed && !pool_installable(pool, s))
+	    continue;
+	  if (!(off = whatdeps_solvable_deps(s, keyname)))
+	    continue;
+	  for (dp = s->repo->idarraydata + off; (dep = *dp) != 0; dp++)
+	    if (dep != SOLVABLE_PREREQMARKER)
+	      whatdeps_adddep(pool, dep, whatdeps, whatdepsdata, i);
+	}
+    }
+  pool->whatdeps[k] = whatdeps;
+  pool->whatdepsdata[k] = whatdepsdata;
+  pool->whatdepsnames[k] = num;
+  POOL_DEBUG(SOLV_DEBUG_STATS, "createwhatdeps for %s took %d ms\n", pool_id2str(pool, keyname), solv_timems(now));
+}
+
+/*
+ * return the 0-terminated list of solvables that have a dependency
+ * of type keyname on name. Use name 0 to get the solvables with
+ * dependencies that are not indexed by name.
+ */
+Id *
+pool_whatdeps_ptr(Pool *pool, Id keyname, Id name)
+{
+  static Id empty[1];
+  int k = whatdeps_slot(keyname);
+
+  if (k < 0)
+    return empty;
+  if (!pool->whatdeps[k])
+    pool_createwhatdeps(pool, k, keyname);
+  while (ISRELDEP(name))
+    name = GETRELDEP(pool, name)->name;
+  if (name >= pool->whatdepsnames[k])
+    return pool->whatdepsdata[k];	/* name created after the index */
+  return pool->whatdepsdata[k] + pool->whatdeps[k][name];
+}
+
+void
+pool_freeupdatecandidates(Pool *pool)
+{
+  int k;
+  for (k = 0; k < 32; k++)
+    pool->updatecands[k] = solv_free(pool->updatecands[k]);
+  pool->updatecandsdata = solv_free(pool->updatecandsdata);
+  pool->updatecandsdatalen = 0;
+  pool->updatecandsnsolvables = 0;
+}
+
+void
+pool_freewhatdeps(Pool *pool)
+{
+  int k;
+  for (k = 0; k < 4; k++)
+    {
+      pool->whatdeps[k] = solv_free(pool->whatdeps[k]);
+      pool->whatdepsdata[k] = solv_free(pool->whatdepsdata[k]);
+      pool->whatdepsnames[k] = 0;
+    }
+}
+
+static int
+whatmatchesdep_match(Pool *pool, Id dep, Id d)
+{
+  while (ISRELDEP(d))
+    {
+      Reldep *rd = GETRELDEP(pool, d);
+      if (rd->flags != REL_AND && rd->flags != REL_OR && rd->flags != REL_WITH)
+	break;
+      if (whatmatchesdep_match(pool, dep, rd->name))
+	return 1;
+      d = rd->evr;
+    }
+  return pool_match_dep(pool, dep, d);
+}
+
+/*
+ * find all solvables with a keyname dependency matching dep,
+ * e.g. the packages that require a provide of some package
+ */
+void
+pool_whatmatchesdep(Pool *pool, Id keyname, Id dep, Queue *q)
+{
+  Id p, *pp, d, *dp;
+  Solvable *s;
+  Offset off;
+
+  queue_empty(q);
+  for (pp = pool_whatdeps_ptr(pool, keyname, dep); (p = *pp) != 0; pp++)
+    {
+      s = pool->solvables + p;
+      off = whatdeps_solvable_deps(s, keyname);
+      for (dp = s->repo->idarraydata + off; (d = *dp) != 0; dp++)
+	if (d != SOLVABLE_PREREQMARKER && whatmatchesdep_match(pool, dep, d))
+	  break;
+      if (d)
+	queue_push(q, p);
+    }
 }
 
 
@@ -988,17 +1228,26 @@ struct addfileprovides_cbdata {
   Map providedids;
 
   Map useddirs;
+
+  /* hash of the files we search for, (dir, name) -> file index + 1 */
+  Hashtable filehashtbl;
+  Hashmask filehashmask;
 };
 
 static int
 addfileprovides_cb(void *cbdata, Solvable *s, Repodata *data, Repokey *key, KeyValue *value)
 {
   struct addfileprovides_cbdata *cbd = cbdata;
-  int i;
+  Hashval h, hh;
+  Hashmask hashmask;
+  Id i;
 
   if (!cbd->useddirs.size)
     {
       map_init(&cbd->useddirs, data->dirpool.ndirs + 1);
+      hashmask = mkmask(cbd->nfiles);
+      cbd->filehashtbl = solv_calloc(hashmask + 1, sizeof(Id));
+      cbd->filehashmask = hashmask;
       for (i = 0; i < cbd->nfiles; i++)
 	{
 	  Id did;
@@ -1009,21 +1258,30 @@ addfileprovides_cb(void *cbdata, Solvable *s, Repodata *data, Repokey *key, KeyV
 	    }
 	  did = repodata_str2dir(data, cbd->dirs[i], 0);
 	  cbd->dids[i] = did;
-	  if (did)
-	    MAPSET(&cbd->useddirs, did);
+	  if (!did)
+	    continue;
+	  MAPSET(&cbd->useddirs, did);
+	  h = strhash_cont(cbd->names[i], did) & hashmask;
+	  hh = HASHCHAIN_START;
+	  while (cbd->filehashtbl[h])
+	    h = HASHCHAIN_NEXT(h, hh, hashmask);
+	  cbd->filehashtbl[h] = i + 1;
 	}
       repodata_free_dircache(data);
     }
   if (value->id >= data->dirpool.ndirs || !MAPTST(&cbd->useddirs, value->id))
     return 0;
-  for (i = 0; i < cbd->nfiles; i++)
+  hashmask = cbd->filehashmask;
+  h = strhash_cont(value->str, value->id) & hashmask;
+  hh = HASHCHAIN_START;
+  while ((i = cbd->filehashtbl[h]) != 0)
     {
-      if (cbd->dids[i] != value->id)
-	continue;
-      if (!strcmp(cbd->names[i], value->str))
+      i--;
+      if (cbd->dids[i] == value->id && !strcmp(cbd->names[i], value->str))
 	break;
+      h = HASHCHAIN_NEXT(h, hh, hashmask);
     }
-  if (i == cbd->nfiles)
+  if (!cbd->filehashtbl[h])
     return 0;
   s->provides = repo_addid_dep(s->repo, s->provides, cbd->ids[i], SOLVABLE_FILEMARKER);
   return 0;
@@ -1038,7 +1296,7 @@ pool_addfileprovides_search(Pool *pool, struct addfileprovides_cbdata *cbd, stru
   Queue fileprovidesq;
   int i, j, repoid, repodataid;
   int provstart, provend;
-  Map donemap;
+  Map donemap, candidates;
   int ndone, incomplete;
 
   if (!pool->urepos)
@@ -1127,6 +1385,23 @@ pool_addfileprovides_search(Pool *pool, struct addfileprovides_cbdata *cbd, stru
 		}
 	    }
 
+	  /* if we have a file list index, only look at the solvables it returns */
+	  map_init(&candidates, 0);
+	  if (data->filelistindex)
+	    {
+	      Id *solvids;
+	      int k, n;
+	      map_init(&candidates, data->end);
+	      for (i = 0; i < cbd->nfiles; i++)
+		{
+		  if (MAPTST(&cbd->providedids, cbd->ids[i]))
+		    continue;
+		  n = repodata_filelistindex_lookup(data, pool_id2str(pool, cbd->ids[i]), &solvids);
+		  for (k = 0; k < n; k++)
+		    MAPSET(&candidates, solvids[k]);
+		}
+	    }
+
 	  /* do the search */
 	  map_init(&cbd->useddirs, 0);
 	  for (p = data->start; p < data->end; p++)
@@ -1134,7 +1409,8 @@ pool_addfileprovides_search(Pool *pool, struct addfileprovides_cbdata *cbd, stru
 	      {
 		if (MAPTST(&donemap, p))
 		  continue;
-	        repodata_search(data, p, SOLVABLE_FILELIST, 0, addfileprovides_cb, cbd);
+		if (!candidates.size || MAPTST(&candidates, p))
+	          repodata_search(data, p, SOLVABLE_FILELIST, 0, addfileprovides_cb, cbd);
 		if (!incomplete)
 		  {
 		    MAPSET(&donemap, p);
@@ -1142,6 +1418,8 @@ pool_addfileprovides_search(Pool *pool, struct addfileprovides_cbdata *cbd, stru
 		  }
 	      }
 	  map_free(&cbd->useddirs);
+	  map_free(&candidates);
+	  cbd->filehashtbl = solv_free(cbd->filehashtbl);
 	}
 
       if (repoonly || ++repoid == pool->nrepos)
@@ -1199,6 +1477,7 @@ pool_addfileprovides_queue(Pool *pool, Queue *idq, Queue *idqinst)
   map_free(&isf.seen);
   POOL_DEBUG(SOLV_DEBUG_STATS, "found %d file dependencies, %d installed file dependencies\n", sf.nfiles, isf.nfiles);
   cbd.dids = 0;
+  cbd.filehashtbl = 0;
   if (sf.nfiles)
     {
 #if 0
@@ -1252,21 +1531,6 @@ pool_addfileprovides(Pool *pool)
   pool_addfileprovides_queue(pool, 0, 0);
 }
 
-void
-pool_search(Pool *pool, Id p, Id key, const char *match, int flags, int (*callback)(void *cbdata, Solvable *s, struct _Repodata *data, struct _Repokey *key, struct _KeyValue *kv), void *cbdata)
-{
-  if (p)
-    {
-      if (pool->solvables[p].repo)
-        repo_search(pool->solvables[p].repo, p, key, match, flags, callback, cbdata);
-      return;
-    }
-  /* FIXME: obey callback return value! */
-  for (p = 1; p < pool->nsolvables; p++)
-    if (pool->solvables[p].repo)
-      repo_search(pool->solvables[p].repo, p, key, match, flags, callback, cbdata);
-}
-
 void
 pool_clear_pos(Pool *pool)
 {
@@ -1453,93 +1717,211 @@ struct mptree {
   Id mountpoint;
 };
 
+#define DUDATA_BLOCK	1023
+
+/* offset of the empty list used for solvables without disk usage data */
+#define DUDATA_NODU	1
+
 struct ducbdata {
   DUChanges *mps;
   struct mptree *mptree;
-  int addsub;
+  int nmps;
   int hasdu;
 
-  Id *dirmap;
-  int nmap;
-  Repodata *olddata;
+  char *mpkey;
+  int mpkeyl;
+  Queue duq;		/* collected (dir, kbytes, files) of one solvable */
+  Id *mpsum;		/* scratch space to aggregate by mount point */
 };
 
-
 static int
 solver_fill_DU_cb(void *cbdata, Solvable *s, Repodata *data, Repokey *key, KeyValue *value)
 {
   struct ducbdata *cbd = cbdata;
-  Id mp;
-
-  if (data != cbd->olddata)
-    {
-      Id dn, mp, comp, *dirmap, *dirs;
-      int i, compl;
-      const char *compstr;
-      struct mptree *mptree;
-
-      /* create map from dir to mptree */
-      cbd->dirmap = solv_free(cbd->dirmap);
-      cbd->nmap = 0;
-      dirmap = solv_calloc(data->dirpool.ndirs, sizeof(Id));
-      mptree = cbd->mptree;
-      mp = 0;
-      for (dn = 2, dirs = data->dirpool.dirs + dn; dn < data->dirpool.ndirs; dn++)
+
+  cbd->hasdu = 1;
+  queue_push(&cbd->duq, value->id);
+  queue_push2(&cbd->duq, value->num, value->num2);
+  return 0;
+}
+
+/* create map from dir to mount point */
+static void
+create_du_dirmap(struct ducbdata *cbd, Repodata *data, struct ducache *dc)
+{
+  Id dn, mp, comp, *dirmap, *dirs;
+  int i, compl;
+  const char *compstr;
+  struct mptree *mptree;
+
+  dirmap = solv_calloc(data->dirpool.ndirs, sizeof(Id));
+  mptree = cbd->mptree;
+  mp = 0;
+  for (dn = 2, dirs = data->dirpool.dirs + dn; dn < data->dirpool.ndirs; dn++)
+    {
+      comp = *dirs++;
+      if (comp <= 0)
 	{
-	  comp = *dirs++;
-	  if (comp <= 0)
-	    {
-	      mp = dirmap[-comp];
-	      continue;
-	    }
-	  if (mp < 0)
-	    {
-	      /* unconnected */
-	      dirmap[dn] = mp;
-	      continue;
-	    }
-	  if (!mptree[mp].child)
-	    {
-	      dirmap[dn] = -mp;
-	      continue;
-	    }
-	  if (data->localpool)
-	    compstr = stringpool_id2str(&data->spool, comp);
-	  else
-	    compstr = pool_id2str(data->repo->pool, comp);
-	  compl = strlen(compstr);
-	  for (i = mptree[mp].child; i; i = mptree[i].sibling)
-	    if (mptree[i].compl == compl && !strncmp(mptree[i].comp, compstr, compl))
-	      break;
-	  dirmap[dn] = i ? i : -mp;
+	  mp = dirmap[-comp];
+	  continue;
+	}
+      if (mp < 0)
+	{
+	  /* unconnected */
+	  dirmap[dn] = mp;
+	  continue;
 	}
-      /* change dirmap to point to mountpoint instead of mptree */
-      for (dn = 0; dn < data->dirpool.ndirs; dn++)
+      if (!mptree[mp].child)
 	{
-	  mp = dirmap[dn];
-	  dirmap[dn] = mptree[mp > 0 ? mp : -mp].mountpoint;
+	  dirmap[dn] = -mp;
+	  continue;
 	}
-      cbd->dirmap = dirmap;
-      cbd->nmap = data->dirpool.ndirs;
-      cbd->olddata = data;
+      if (data->localpool)
+	compstr = stringpool_id2str(&data->spool, comp);
+      else
+	compstr = pool_id2str(data->repo->pool, comp);
+      compl = strlen(compstr);
+      for (i = mptree[mp].child; i; i = mptree[i].sibling)
+	if (mptree[i].compl == compl && !strncmp(mptree[i].comp, compstr, compl))
+	  break;
+      dirmap[dn] = i ? i : -mp;
     }
-  cbd->hasdu = 1;
-  if (value->id < 0 || value->id >= cbd->nmap)
-    return 0;
-  mp = cbd->dirmap[value->id];
-  if (mp < 0)
-    return 0;
-  if (cbd->addsub > 0)
+  /* change dirmap to point to mountpoint instead of mptree */
+  for (dn = 0; dn < data->dirpool.ndirs; dn++)
     {
-      cbd->mps[mp].kbytes += value->num;
-      cbd->mps[mp].files += value->num2;
+      mp = dirmap[dn];
+      dirmap[dn] = mptree[mp > 0 ? mp : -mp].mountpoint;
     }
-  else
+  dc->dirmap = dirmap;
+  dc->ndirmap = data->dirpool.ndirs;
+}
+
+/* return the aggregated disk usage of solvable p in the repodata,
+ * or 0 if there is no disk usage data for it */
+static Id *
+repodata_lookup_du(struct ducbdata *cbd, Repodata *data, Id p)
+{
+  struct ducache *dc = data->ducache;
+  Id *dp, mp;
+  int i, off, nmp;
+
+  if (dc && (dc->mpkeyl != cbd->mpkeyl || memcmp(dc->mpkey, cbd->mpkey, cbd->mpkeyl) != 0))
     {
-      cbd->mps[mp].kbytes -= value->num;
-      cbd->mps[mp].files -= value->num2;
+      repodata_free_ducache(data);
+      dc = 0;
     }
-  return 0;
+  if (dc && (off = dc->offsets[p - data->start]) != 0)
+    return off == DUDATA_NODU ? 0 : dc->dudata + off;
+
+  cbd->hasdu = 0;
+  queue_empty(&cbd->duq);
+  repodata_search(data, p, SOLVABLE_DISKUSAGE, 0, solver_fill_DU_cb, cbd);
+  if (data->state != REPODATA_AVAILABLE)
+    return 0;	/* could not load data, try again next time */
+  dc = data->ducache;	/* loading may have freed the old cache */
+  if (!dc)
+    {
+      dc = data->ducache = solv_calloc(1, sizeof(*dc));
+      dc->mpkey = solv_malloc(cbd->mpkeyl + 1);
+      memcpy(dc->mpkey, cbd->mpkey, cbd->mpkeyl);
+      dc->mpkeyl = cbd->mpkeyl;
+      dc->noffsets = data->end - data->start;
+      dc->offsets = solv_calloc(dc->noffsets, sizeof(Id));
+      dc->dudata = solv_extend_resize(0, 2, sizeof(Id), DUDATA_BLOCK);
+      dc->dudata[0] = 0;
+      dc->dudata[DUDATA_NODU] = 0;
+      dc->ndudata = 2;
+    }
+  if (!dc->dirmap)
+    create_du_dirmap(cbd, data, dc);
+  if (!cbd->hasdu)
+    {
+      dc->offsets[p - data->start] = DUDATA_NODU;
+      return 0;
+    }
+
+  /* aggregate by mount point */
+  nmp = 0;
+  for (i = 0; i < cbd->duq.count; i += 3)
+    {
+      Id dir = cbd->duq.elements[i];
+      if (dir < 0 || dir >= dc->ndirmap)
+	continue;
+      mp = dc->dirmap[dir];
+      if (mp < 0)
+	continue;
+      if (!cbd->mpsum[3 * mp])
+	{
+	  cbd->mpsum[3 * mp] = ++nmp;
+	  cbd->mpsum[3 * mp + 1] = 0;
+	  cbd->mpsum[3 * mp + 2] = 0;
+	}
+      cbd->mpsum[3 * mp + 1] += cbd->duq.elements[i + 1];
+      cbd->mpsum[3 * mp + 2] += cbd->duq.elements[i + 2];
+    }
+  off = dc->ndudata;
+  dc->dudata = solv_extend(dc->dudata, dc->ndudata, 3 * nmp + 1, sizeof(Id), DUDATA_BLOCK);
+  dp = dc->dudata + off;
+  for (mp = 0; nmp && mp < cbd->nmps; mp++)
+    {
+      if (!cbd->mpsum[3 * mp])
+	continue;
+      *dp++ = mp + 1;
+      *dp++ = cbd->mpsum[3 * mp + 1];
+      *dp++ = cbd->mpsum[3 * mp + 2];
+      cbd->mpsum[3 * mp] = 0;
+      nmp--;
+    }
+  *dp++ = 0;
+  dc->ndudata = dp - dc->dudata;
+  dc->offsets[p - data->start] = off;
+  return dc->dudata + off;
+}
+
+/* add/subtract the disk usage of a solvable. Returns 0 if the
+ * solvable has no disk usage data */
+static int
+solvable_add_du(struct ducbdata *cbd, Solvable *s, int addsub)
+{
+  Pool *pool = s->repo->pool;
+  Repo *repo = s->repo;
+  Repodata *data;
+  Id p = s - pool->solvables;
+  Id *dp;
+  int rdid, hasdu = 0;
+
+  if (repo->disabled)
+    return 0;
+  FOR_REPODATAS(repo, rdid, data)
+    {
+      if (p < data->start || p >= data->end)
+	continue;
+      if (!repodata_precheck_keyname(data, SOLVABLE_DISKUSAGE))
+	continue;
+      if (data->state == REPODATA_ERROR)
+	continue;
+      if (data->ducache && data->ducache->noffsets != data->end - data->start)
+	repodata_free_ducache(data);
+      dp = repodata_lookup_du(cbd, data, p);
+      if (!dp)
+	continue;
+      hasdu = 1;
+      for (; *dp; dp += 3)
+	{
+	  DUChanges *mps = cbd->mps + (dp[0] - 1);
+	  if (addsub > 0)
+	    {
+	      mps->kbytes += dp[1];
+	      mps->files += dp[2];
+	    }
+	  else
+	    {
+	      mps->kbytes -= dp[1];
+	      mps->files -= dp[2];
+	    }
+	}
+    }
+  return hasdu;
 }
 
 static void
@@ -1572,11 +1954,9 @@ pool_calc_duchanges(Pool *pool, Map *installedmap, DUChanges *mps, int nmps)
   Repo *oldinstalled = pool->installed;
 
   memset(&ignoredu, 0, sizeof(ignoredu));
+  memset(&cbd, 0, sizeof(cbd));
   cbd.mps = mps;
-  cbd.addsub = 0;
-  cbd.dirmap = 0;
-  cbd.nmap = 0;
-  cbd.olddata = 0;
+  cbd.nmps = nmps;
 
   mptree = solv_extend_resize(0, 1, sizeof(struct mptree), MPTREE_BLOCK);
 
@@ -1595,6 +1975,11 @@ pool_calc_duchanges(Pool *pool, Map *installedmap, DUChanges *mps, int nmps)
       mps[mp].files = 0;
       pos = 0;
       path = mps[mp].path;
+      /* also remember the mount points for the cache */
+      compl = strlen(path) + 1;
+      cbd.mpkey = solv_extend(cbd.mpkey, cbd.mpkeyl, compl, 1, 255);
+      memcpy(cbd.mpkey + cbd.mpkeyl, path, compl);
+      cbd.mpkeyl += compl;
       while(*path == '/')
 	path++;
       while (*path)
@@ -1647,16 +2032,14 @@ pool_calc_duchanges(Pool *pool, Map *installedmap, DUChanges *mps, int nmps)
 #endif
 
   cbd.mptree = mptree;
-  cbd.addsub = 1;
-  for (sp = 1, s = pool->solvables + sp; sp < pool->nsolvables; sp++, s++)
+  cbd.mpsum = solv_calloc(3 * nmps + 1, sizeof(Id));
+  queue_init(&cbd.duq);
+  for (sp = map_next(installedmap, 1); sp >= 0 && sp < pool->nsolvables; sp = map_next(installedmap, sp + 1))
     {
+      s = pool->solvables + sp;
       if (!s->repo || (oldinstalled && s->repo == oldinstalled))
 	continue;
-      if (!MAPTST(installedmap, sp))
-	continue;
-      cbd.hasdu = 0;
-      repo_search(s->repo, sp, SOLVABLE_DISKUSAGE, 0, 0, solver_fill_DU_cb, &cbd);
-      if (!cbd.hasdu && oldinstalled)
+      if (!solvable_add_du(&cbd, s, 1) && oldinstalled)
 	{
 	  Id op, opp;
 	  /* no du data available, ignore data of all installed solvables we obsolete */
@@ -1676,7 +2059,6 @@ pool_calc_duchanges(Pool *pool, Map *installedmap, DUChanges *mps, int nmps)
 		MAPSET(&ignoredu, op - oldinstalled->start);
 	}
     }
-  cbd.addsub = -1;
   if (oldinstalled)
     {
       /* assumes we allways have du data for installed solvables */
@@ -1686,12 +2068,14 @@ pool_calc_duchanges(Pool *pool, Map *installedmap, DUChanges *mps, int nmps)
 	    continue;
 	  if (ignoredu.map && MAPTST(&ignoredu, sp - oldinstalled->start))
 	    continue;
-	  repo_search(oldinstalled, sp, SOLVABLE_DISKUSAGE, 0, 0, solver_fill_DU_cb, &cbd);
+	  solvable_add_du(&cbd, s, -1);
 	}
     }
   if (ignoredu.map)
     map_free(&ignoredu);
-  solv_free(cbd.dirmap);
+  queue_free(&cbd.duq);
+  solv_free(cbd.mpsum);
+  solv_free(cbd.mpkey);
   solv_free(mptree);
 }
 
@@ -1703,12 +2087,11 @@ pool_calc_installsizechange(Pool *pool, Map *installedmap)
   int change = 0;
   Repo *oldinstalled = pool->installed;
 
-  for (sp = 1, s = pool->solvables + sp; sp < pool->nsolvables; sp++, s++)
+  for (sp = map_next(installedmap, 1); sp >= 0 && sp < pool->nsolvables; sp = map_next(installedmap, sp + 1))
     {
+      s = pool->solvables + sp;
       if (!s->repo || (oldinstalled && s->repo == oldinstalled))
 	continue;
-      if (!MAPTST(installedmap, sp))
-	continue;
       change += solvable_lookup_num(s, SOLVABLE_INSTALLSIZE, 0);
     }
   if (oldinstalled)
@@ -1799,10 +2182,8 @@ pool_trivial_installable_noobsoletesmap(Pool *pool, Map *installedmap, Queue *pk
   Solvable *s;
 
   map = solv_calloc(pool->nsolvables, 1);
-  for (p = 1; p < pool->nsolvables; p++)
+  for (p = map_next(installedmap, 1); p >= 0 && p < pool->nsolvables; p = map_next(installedmap, p + 1))
     {
-      if (!MAPTST(installedmap, p))
-	continue;
       map[p] |= 9;
       s = pool->solvables + p;
       if (!s->conflicts)
@@ -136,6 +136,38 @@ struct _Pool {
   Id *languagecache;
   int languagecacheother;
 
+  /* reverse dependency index, created on demand by pool_whatdeps_ptr()
+   * whatdeps[k][Id] -> Offset into whatdepsdata[k] for name
+   * whatdepsdata[k][Offset] -> 0-terminated list of solvables with a
+   *                            dependency of type k on name
+   * k is 0 for requires, 1 for recommends, 2 for supplements, 3 for enhances
+   */
+  Offset *whatdeps[4];
+  Id *whatdepsdata[4];
+  Id whatdepsnames[4];		/* number of names covered by whatdeps[k] */
+
+  /* obsoletes index of the installed packages, shared by all solvers
+   * and created by policy_create_obsolete_index()
+   * obsoletes[p - installed->start] -> Offset into obsoletes_data
+   */
+  Id *obsoletes;
+  Id *obsoletes_data;
+  int obsoletes_datasize;
+  int obsoletes_nsolvables;	/* nsolvables at index creation time */
+  Map obsoletes_considered;	/* considered map at index creation time */
+  int obsoletes_generation;	/* incremented whenever the index changes */
+
+  /* update candidates of the installed packages, created on demand by
+   * policy_findupdatepackages()
+   * updatecands[k][p - installed->start] -> Offset into updatecandsdata,
+   * 0 if not computed yet. k is the mask of the allow flags used.
+   * The cache belongs to the obsoletes index of obsoletes_generation.
+   */
+  Offset *updatecands[32];
+  Id *updatecandsdata;
+  int updatecandsdatalen;
+  int updatecandsnsolvables;	/* nsolvables at cache creation time */
+
   /* our tmp space string space */
   struct _Pool_tmpspace tmpspace;
 #endif
@@ -272,6 +304,12 @@ extern Id pool_queuetowhatprovides(Pool *pool, Queue *q);
 
 extern Id pool_addrelproviders(Pool *pool, Id d);
 
+/* reverse dependency index: solvables with a keyname dependency on name */
+extern Id *pool_whatdeps_ptr(Pool *pool, Id keyname, Id name);
+extern void pool_freewhatdeps(Pool *pool);
+extern void pool_freeupdatecandidates(Pool *pool);
+extern void pool_whatmatchesdep(Pool *pool, Id keyname, Id dep, Queue *q);
+
 static inline Id pool_whatprovides(Pool *pool, Id d)
 {
   Id v;
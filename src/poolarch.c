@@ -94,6 +94,7 @@ pool_setarchpolicy(Pool *pool, const char *arch)
 
   pool->id2arch = solv_free(pool->id2arch);
   pool->id2color = solv_free(pool->id2color);
+  pool_freeupdatecandidates(pool);
   if (!arch)
     {
       pool->lastarch = 0;
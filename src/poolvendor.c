@@ -85,6 +85,7 @@ pool_setvendorclasses(Pool *pool, const char **vendorclasses)
   int i;
   const char **v;
 
+  pool_freeupdatecandidates(pool);
   if (pool->vendorclasses)
     {
       for (v = pool->vendorclasses; v[0] || v[1]; v++)
@@ -110,6 +111,7 @@ pool_addvendorclass(Pool *pool, const char **vendorclass)
 
   if (!vendorclass || !vendorclass[0])
     return;
+  pool_freeupdatecandidates(pool);
   for (j = 1; vendorclass[j]; j++)
     ;
   i = 0;
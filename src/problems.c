@@ -226,6 +226,8 @@ refine_suggestion(Solver *solv, Id *problem, Id sug, Queue *refined, int essenti
 
       if (!solv->problems.count)
         solver_run_sat(solv, 0, 0);
+      if (solv->aborted)
+	break;		/* out of budget, caller cleans up */
 
       if (!solv->problems.count)
 	{
@@ -529,11 +531,13 @@ create_solutions(Solver *solv, int probnr, int solidx)
   Queue problem, solution, problems_save;
   int i, j, nsol;
   int essentialok;
+  int oldsolcount = solv->solutions.count;
   unsigned int now;
   int oldmistakes = solv->cleandeps_mistakes ? solv->cleandeps_mistakes->count : 0;
   Id extraflags = -1;
 
   now = solv_timems(0);
+  solver_start_budget(solv);
   queue_init(&redoq);
   /* save decisionq, decisionq_why, decisionmap */
   for (i = 0; i < solv->decisionq.count; i++)
@@ -577,6 +581,8 @@ create_solutions(Solver *solv, int probnr, int solidx)
     {
       int solstart = solv->solutions.count;
       refine_suggestion(solv, problem.elements, problem.elements[i], &solution, essentialok);
+      if (solv->aborted)
+	break;
       queue_push(&solv->solutions, 0);	/* reserve room for number of elements */
       for (j = 0; j < solution.count; j++)
 	convertsolution(solv, solution.elements[j], &solv->solutions);
@@ -617,8 +623,20 @@ create_solutions(Solver *solv, int probnr, int solidx)
       queue_push(&solv->solutions, extraflags & SOLVER_CLEANDEPS);	/* our extraflags */
       solv->solutions.elements[solidx + 1 + nsol++] = solstart;
     }
-  solv->solutions.elements[solidx + 1 + nsol] = 0;	/* end marker */
-  solv->solutions.elements[solidx] = nsol;
+  if (solv->aborted)
+    {
+      /* out of budget. put back the problem and leave it unrefined, so
+       * that we can try again with a bigger budget */
+      POOL_DEBUG(SOLV_DEBUG_SOLUTIONS, "solution creation aborted\n");
+      queue_truncate(&solv->solutions, oldsolcount);
+      for (i = 0; i < problem.count; i++)
+	solv->solutions.elements[solidx + 1 + i] = problem.elements[i];
+    }
+  else
+    {
+      solv->solutions.elements[solidx + 1 + nsol] = 0;	/* end marker */
+      solv->solutions.elements[solidx] = nsol;
+    }
   queue_free(&problem);
   queue_free(&solution);
 
@@ -675,6 +693,8 @@ solver_solution_count(Solver *solv, Id problem)
   Id solidx = solv->problems.elements[problem * 2 - 1];
   if (solv->solutions.elements[solidx] < 0)
     create_solutions(solv, problem, solidx);
+  if (solv->solutions.elements[solidx] < 0)
+    return 0;	/* aborted */
   return solv->solutions.elements[solidx];
 }
 
@@ -684,6 +704,8 @@ solver_next_solution(Solver *solv, Id problem, Id solution)
   Id solidx = solv->problems.elements[problem * 2 - 1];
   if (solv->solutions.elements[solidx] < 0)
     create_solutions(solv, problem, solidx);
+  if (solv->solutions.elements[solidx] < 0)
+    return 0;	/* aborted */
   return solv->solutions.elements[solidx + solution + 1] ? solution + 1 : 0;
 }
 
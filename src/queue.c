@@ -19,6 +19,15 @@
 #define EXTRA_SPACE 8
 #define EXTRA_SPACE_HEAD 8
 
+/* grow big queues by a fraction of their size, so that filling
+ * a queue does not need a realloc every EXTRA_SPACE elements */
+static inline int
+queue_extra_space(int size)
+{
+  size >>= 2;
+  return size > EXTRA_SPACE ? size : EXTRA_SPACE;
+}
+
 void
 queue_init(Queue *q)
 {
@@ -65,11 +74,12 @@ queue_alloc_one(Queue *q)
 {
   if (!q->alloc)
     {
-      q->alloc = solv_malloc2(q->count + EXTRA_SPACE, sizeof(Id));
+      int extra = queue_extra_space(q->count);
+      q->alloc = solv_malloc2(q->count + extra, sizeof(Id));
       if (q->count)
 	memcpy(q->alloc, q->elements, q->count * sizeof(Id));
       q->elements = q->alloc;
-      q->left = EXTRA_SPACE;
+      q->left = extra;
     }
   else if (q->alloc != q->elements)
     {
@@ -81,8 +91,9 @@ queue_alloc_one(Queue *q)
     }
   else
     {
-      q->elements = q->alloc = solv_realloc2(q->alloc, q->count + EXTRA_SPACE, sizeof(Id));
-      q->left = EXTRA_SPACE;
+      int extra = queue_extra_space(q->count);
+      q->elements = q->alloc = solv_realloc2(q->alloc, q->count + extra, sizeof(Id));
+      q->left = extra;
     }
 }
 
@@ -1051,6 +1051,39 @@ repo_search(Repo *repo, Id p, Id keyname, const char *match, int flags, int (*ca
     datamatcher_free(&md.matcher);
 }
 
+/* search all solvables of the pool. Unlike calling repo_search for
+ * every solvable, the matcher is set up just once */
+void
+pool_search(Pool *pool, Id p, Id keyname, const char *match, int flags, int (*callback)(void *cbdata, Solvable *s, Repodata *data, Repokey *key, KeyValue *kv), void *cbdata)
+{
+  struct matchdata md;
+  Solvable *s;
+
+  if (p)
+    {
+      if (pool->solvables[p].repo)
+        repo_search(pool->solvables[p].repo, p, keyname, match, flags, callback, cbdata);
+      return;
+    }
+  memset(&md, 0, sizeof(md));
+  md.pool = pool;
+  md.flags = flags;
+  md.callback = callback;
+  md.callback_data = cbdata;
+  if (match)
+    datamatcher_init(&md.matcher, match, flags);
+  for (p = 1, s = pool->solvables + p; p < pool->nsolvables; p++, s++)
+    {
+      if (!s->repo || (s->repo->disabled && !(flags & SEARCH_DISABLED_REPOS)))
+	continue;
+      repo_search_md(s->repo, p, keyname, &md);
+      if (md.stop > SEARCH_NEXT_SOLVABLE)
+	break;
+    }
+  if (match)
+    datamatcher_free(&md.matcher);
+}
+
 const char *
 repo_lookup_str(Repo *repo, Id entry, Id keyname)
 {
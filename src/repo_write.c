@@ -355,6 +355,8 @@ write_idarray_sort(FILE *fp, Pool *pool, NeedId *needid, Id *ids, Id marker)
 struct extdata {
   unsigned char *buf;
   int len;
+  FILE *spillfp;	/* vertical data moved out of buf */
+  int spilled;		/* number of bytes in spillfp */
 };
 
 struct cbdata {
@@ -389,12 +391,14 @@ struct cbdata {
   Id lastlen;
 
   int doingsolvables;	/* working on solvables data */
+  int nospill;		/* could not create a spill file */
 };
 
 #define NEEDED_BLOCK 1023
 #define SCHEMATA_BLOCK 31
 #define SCHEMATADATA_BLOCK 255
 #define EXTDATA_BLOCK 4095
+#define EXTDATA_SPILLSIZE (1 << 20)
 
 static inline void
 data_addid(struct extdata *xd, Id sx)
@@ -565,6 +569,31 @@ data_addu32(struct extdata *xd, unsigned int num)
   data_addblob(xd, d, 4);
 }
 
+/*
+ * move the vertical data of a key into a temporary file so that
+ * we do not need to keep all of it in memory. The data is read
+ * back when the pages get written.
+ */
+static void
+data_spill(struct cbdata *cbdata, struct extdata *xd)
+{
+  if (!xd->spillfp)
+    {
+      if (cbdata->nospill || (xd->spillfp = tmpfile()) == 0)
+	{
+	  cbdata->nospill = 1;
+	  return;
+	}
+    }
+  if (fwrite(xd->buf, xd->len, 1, xd->spillfp) != 1)
+    {
+      perror("write error spill");
+      exit(1);
+    }
+  xd->spilled += xd->len;
+  xd->len = 0;
+}
+
 static Id
 putinownpool(struct cbdata *cbdata, Stringpool *ss, Id id)
 {
@@ -769,7 +798,7 @@ repo_write_adddata(struct cbdata *cbdata, Repodata *data, Repokey *key, KeyValue
     {
       xd = cbdata->extdata + rm;	/* vertical buffer */
       if (cbdata->vstart == -1)
-        cbdata->vstart = xd->len;
+        cbdata->vstart = xd->spilled + xd->len;
     }
   else
     xd = cbdata->extdata + 0;		/* incore buffer */
@@ -884,8 +913,10 @@ repo_write_adddata(struct cbdata *cbdata, Repodata *data, Repokey *key, KeyValue
     {
       /* we can re-use old data in the blob here! */
       data_addid(cbdata->extdata + 0, cbdata->vstart);			/* add offset into incore data */
-      data_addid(cbdata->extdata + 0, xd->len - cbdata->vstart);	/* add length into incore data */
+      data_addid(cbdata->extdata + 0, xd->spilled + xd->len - cbdata->vstart);	/* add length into incore data */
       cbdata->vstart = -1;
+      if (xd->len >= EXTDATA_SPILLSIZE)
+	data_spill(cbdata, xd);
     }
   return 0;
 }
@@ -1875,7 +1906,7 @@ fprintf(stderr, "dir %d used %d\n", i, cbdata.dirused ? cbdata.dirused[i] : 1);
             write_id(fp, target.keys[i].size);
 	}
       else
-        write_id(fp, cbdata.extdata[i].len);
+        write_id(fp, cbdata.extdata[i].spilled + cbdata.extdata[i].len);
       write_id(fp, target.keys[i].storage);
     }
 
@@ -1896,7 +1927,7 @@ fprintf(stderr, "dir %d used %d\n", i, cbdata.dirused ? cbdata.dirused[i] : 1);
 
   /* do we have vertical data? */
   for (i = 1; i < target.nkeys; i++)
-    if (cbdata.extdata[i].len)
+    if (cbdata.extdata[i].spilled || cbdata.extdata[i].len)
       break;
   if (i < target.nkeys)
     {
@@ -1907,10 +1938,35 @@ fprintf(stderr, "dir %d used %d\n", i, cbdata.dirused ? cbdata.dirused[i] : 1);
       write_u32(fp, REPOPAGE_BLOBSIZE);
       for (i = 1; i < target.nkeys; i++)
 	{
-	  if (!cbdata.extdata[i].len)
+	  xd = cbdata.extdata + i;
+	  if (xd->spillfp)
+	    {
+	      /* first the spilled part */
+	      rewind(xd->spillfp);
+	      for (l = xd->spilled; l; l -= ll)
+		{
+		  ll = REPOPAGE_BLOBSIZE - lpage;
+		  if (l < ll)
+		    ll = l;
+		  if (fread(vpage + lpage, ll, 1, xd->spillfp) != 1)
+		    {
+		      perror("read error spill");
+		      exit(1);
+		    }
+		  lpage += ll;
+		  if (lpage == REPOPAGE_BLOBSIZE)
+		    {
+		      write_compressed_page(fp, vpage, lpage);
+		      lpage = 0;
+		    }
+		}
+	      fclose(xd->spillfp);
+	      xd->spillfp = 0;
+	    }
+	  if (!xd->len)
 	    continue;
-	  l = cbdata.extdata[i].len;
-	  dp = cbdata.extdata[i].buf;
+	  l = xd->len;
+	  dp = xd->buf;
 	  while (l)
 	    {
 	      ll = REPOPAGE_BLOBSIZE - lpage;
@@ -1926,13 +1982,18 @@ fprintf(stderr, "dir %d used %d\n", i, cbdata.dirused ? cbdata.dirused[i] : 1);
 		  lpage = 0;
 		}
 	    }
+	  xd->buf = solv_free(xd->buf);
 	}
       if (lpage)
 	write_compressed_page(fp, vpage, lpage);
     }
 
   for (i = 1; i < target.nkeys; i++)
-    solv_free(cbdata.extdata[i].buf);
+    {
+      if (cbdata.extdata[i].spillfp)
+	fclose(cbdata.extdata[i].spillfp);
+      solv_free(cbdata.extdata[i].buf);
+    }
   solv_free(cbdata.extdata);
 
   repodata_freedata(&target);
@@ -17,6 +17,7 @@
 #define _GNU_SOURCE
 #include <string.h>
 #include <fnmatch.h>
+#include <ctype.h>
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -37,6 +38,7 @@
 #define REPODATA_BLOCK 255
 
 static unsigned char *data_skip_key(Repodata *data, unsigned char *dp, Repokey *key);
+static void repodata_free_attrarena(Repodata *data);
 
 void
 repodata_initdata(Repodata *data, Repo *repo, int localpool)
@@ -60,8 +62,6 @@ repodata_initdata(Repodata *data, Repo *repo, int localpool)
 void
 repodata_freedata(Repodata *data)
 {
-  int i;
-
   solv_free(data->keys);
 
   solv_free(data->schemata);
@@ -72,6 +72,7 @@ repodata_freedata(Repodata *data)
   dirpool_free(&data->dirpool);
 
   solv_free(data->mainschemaoffsets);
+  solv_free(data->lastkeyoffsets);
   solv_free(data->incoredata);
   solv_free(data->incoreoffset);
   solv_free(data->verticaloffset);
@@ -80,20 +81,19 @@ repodata_freedata(Repodata *data)
 
   solv_free(data->vincore);
 
-  if (data->attrs)
-    for (i = 0; i < data->end - data->start; i++)
-      solv_free(data->attrs[i]);
   solv_free(data->attrs);
-  if (data->xattrs)
-    for (i = 0; i < data->nxattrs; i++)
-      solv_free(data->xattrs[i]);
   solv_free(data->xattrs);
+  repodata_free_attrarena(data);
 
   solv_free(data->attrdata);
   solv_free(data->attriddata);
   solv_free(data->attrnum64data);
 
   solv_free(data->dircache);
+  repodata_free_ducache(data);
+  repodata_free_filelistindex(data);
+  repodata_free_stringindex(data);
+  repodata_free_keycolumns(data);
 }
 
 void
@@ -174,43 +174,65 @@ repodata_key2id(Repodata *data, Repokey *key, int create)
 #define SCHEMATA_BLOCK 31
 #define SCHEMATADATA_BLOCK 255
 
+static inline Hashval
+schemahash(Id *schema, int *lenp)
+{
+  Id *sp;
+  Hashval h = 0;
+  for (sp = schema; *sp; sp++)
+    h = h * 0x9e3779b1 + *sp;
+  *lenp = sp - schema + 1;
+  return h ^ (h >> 16);
+}
+
+static void
+repodata_rehash_schemata(Repodata *data)
+{
+  Hashval h, hh;
+  Hashmask hashmask;
+  Id *schematahash;
+  int i, len;
+
+  hashmask = mkmask(data->nschemata + SCHEMATA_BLOCK);
+  solv_free(data->schematahash);
+  data->schematahash = schematahash = solv_calloc(hashmask + 1, sizeof(Id));
+  data->schematahashmask = hashmask;
+  for (i = 1; i < data->nschemata; i++)
+    {
+      h = schemahash(data->schemadata + data->schemata[i], &len) & hashmask;
+      hh = HASHCHAIN_START;
+      while (schematahash[h])
+	h = HASHCHAIN_NEXT(h, hh, hashmask);
+      schematahash[h] = i;
+    }
+}
+
 Id
 repodata_schema2id(Repodata *data, Id *schema, int create)
 {
-  int h, len, i;
-  Id *sp, cid;
+  int len;
+  Id cid;
   Id *schematahash;
+  Hashval h, hh;
+  Hashmask hashmask;
 
   if (!*schema)
     return 0;	/* XXX: allow empty schema? */
-  if ((schematahash = data->schematahash) == 0)
+  if (!data->schematahash)
     {
-      data->schematahash = schematahash = solv_calloc(256, sizeof(Id));
-      for (i = 1; i < data->nschemata; i++)
-	{
-	  for (sp = data->schemadata + data->schemata[i], h = 0; *sp; len++)
-	    h = h * 7 + *sp++;
-	  h &= 255;
-	  schematahash[h] = i;
-	}
+      repodata_rehash_schemata(data);
       data->schemadata = solv_extend_resize(data->schemadata, data->schemadatalen, sizeof(Id), SCHEMATADATA_BLOCK);
       data->schemata = solv_extend_resize(data->schemata, data->nschemata, sizeof(Id), SCHEMATA_BLOCK);
     }
-
-  for (sp = schema, len = 0, h = 0; *sp; len++)
-    h = h * 7 + *sp++;
-  h &= 255;
-  len++;
-
-  cid = schematahash[h];
-  if (cid)
+  schematahash = data->schematahash;
+  hashmask = data->schematahashmask;
+  h = schemahash(schema, &len) & hashmask;
+  hh = HASHCHAIN_START;
+  while ((cid = schematahash[h]) != 0)
     {
       if (!memcmp(data->schemadata + data->schemata[cid], schema, len * sizeof(Id)))
         return cid;
-      /* cache conflict, do a slow search */
-      for (cid = 1; cid < data->nschemata; cid++)
-        if (!memcmp(data->schemadata + data->schemata[cid], schema, len * sizeof(Id)))
-          return cid;
+      h = HASHCHAIN_NEXT(h, hh, hashmask);
     }
   /* a new one */
   if (!create)
@@ -225,7 +247,10 @@ repodata_schema2id(Repodata *data, Id *schema, int create)
 #if 0
 fprintf(stderr, "schema2id: new schema\n");
 #endif
-  return data->nschemata++;
+  cid = data->nschemata++;
+  if ((Hashval)data->nschemata * 2 > hashmask)
+    repodata_rehash_schemata(data);
+  return cid;
 }
 
 void
@@ -344,6 +369,19 @@ repodata_free_dircache(Repodata *data)
   data->dircache = solv_free(data->dircache);
 }
 
+void
+repodata_free_ducache(Repodata *data)
+{
+  struct ducache *dc = data->ducache;
+  if (!dc)
+    return;
+  solv_free(dc->mpkey);
+  solv_free(dc->dirmap);
+  solv_free(dc->offsets);
+  solv_free(dc->dudata);
+  data->ducache = solv_free(dc);
+}
+
 const char *
 repodata_dir2str(Repodata *data, Id did, const char *suf)
 {
@@ -470,6 +508,48 @@ forward_to_key(Repodata *data, Id keyid, Id *keyp, unsigned char *dp)
   return 0;
 }
 
+/* like forward_to_key, but remember the key positions of the last
+ * solvable, so that looking up more keys of the same solvable does
+ * not skip over the same data again */
+static unsigned char *
+forward_to_keypos(Repodata *data, Id solvid, Id *keyp, int keypos, unsigned char *dp)
+{
+  int i;
+  Id k;
+
+  if (data->lastkeysolvid != solvid)
+    {
+      data->lastkeysolvid = solvid;
+      data->nlastkeyoffsets = 0;
+    }
+  if (!data->nlastkeyoffsets)
+    {
+      if (!data->lastkeyoffsets)
+	data->lastkeyoffsets = solv_calloc(16, sizeof(Id));
+      data->lastkeyoffsets[0] = dp - data->incoredata;
+      data->nlastkeyoffsets = 1;
+    }
+  i = data->nlastkeyoffsets;
+  if (keypos < i)
+    return data->incoredata + data->lastkeyoffsets[keypos];
+  data->lastkeyoffsets = solv_extend(data->lastkeyoffsets, i, keypos + 1 - i, sizeof(Id), 15);
+  dp = data->incoredata + data->lastkeyoffsets[i - 1];
+  for (; i <= keypos; i++)
+    {
+      k = keyp[i - 1];
+      if (data->keys[k].storage == KEY_STORAGE_VERTICAL_OFFSET)
+	{
+	  dp = data_skip(dp, REPOKEY_TYPE_ID);	/* skip offset */
+	  dp = data_skip(dp, REPOKEY_TYPE_ID);	/* skip length */
+	}
+      else if (data->keys[k].storage == KEY_STORAGE_INCORE)
+	dp = data_skip_key(data, dp, data->keys + k);
+      data->lastkeyoffsets[i] = dp - data->incoredata;
+    }
+  data->nlastkeyoffsets = i;
+  return dp;
+}
+
 static unsigned char *
 get_vertical_data(Repodata *data, Repokey *key, Id off, Id len)
 {
@@ -592,6 +672,28 @@ solvid2data(Repodata *data, Id solvid, Id *schemap)
  * data lookup
  */
 
+/* key columns: the type and value of a fixed size key for every
+ * solvable of the repodata, so that lookups do not need to decode
+ * the schema and the key data */
+struct keycolumn {
+  struct keycolumn *next;
+  Id keyname;
+  Id start;
+  Id end;
+  Id *types;		/* key type, 0 if the solvable does not have the key */
+  unsigned int *values;	/* num or id */
+};
+
+static inline struct keycolumn *
+find_keycolumn(Repodata *data, Id solvid, Id keyname)
+{
+  struct keycolumn *col;
+  for (col = data->keycolumns; col; col = col->next)
+    if (col->keyname == keyname)
+      return solvid >= col->start && solvid < col->end ? col : 0;
+  return 0;
+}
+
 static inline unsigned char *
 find_key_data(Repodata *data, Id solvid, Id keyname, Repokey **keypp)
 {
@@ -615,7 +717,10 @@ find_key_data(Repodata *data, Id solvid, Id keyname, Repokey **keypp)
     return 0;
   if (key->type == REPOKEY_TYPE_VOID || key->type == REPOKEY_TYPE_CONSTANT || key->type == REPOKEY_TYPE_CONSTANTID)
     return dp;	/* no need to forward... */
-  dp = forward_to_key(data, *kp, keyp, dp);
+  if (solvid > 0)
+    dp = forward_to_keypos(data, solvid, keyp, kp - keyp, dp);
+  else
+    dp = forward_to_key(data, *kp, keyp, dp);
   if (!dp)
     return 0;
   return get_data(data, key, &dp, 0);
@@ -625,6 +730,9 @@ Id
 repodata_lookup_type(Repodata *data, Id solvid, Id keyname)
 {
   Id schema, *keyp, *kp;
+  struct keycolumn *col;
+  if (data->keycolumns && (col = find_keycolumn(data, solvid, keyname)) != 0)
+    return col->types[solvid - col->start];
   if (!maybe_load_repodata(data, keyname))
     return 0;
   if (!solvid2data(data, solvid, &schema))
@@ -642,7 +750,15 @@ repodata_lookup_id(Repodata *data, Id solvid, Id keyname)
   unsigned char *dp;
   Repokey *key;
   Id id;
+  struct keycolumn *col;
 
+  if (data->keycolumns && (col = find_keycolumn(data, solvid, keyname)) != 0)
+    {
+      Id type = col->types[solvid - col->start];
+      if (type == REPOKEY_TYPE_ID || type == REPOKEY_TYPE_CONSTANTID)
+	return col->values[solvid - col->start];
+      return 0;
+    }
   dp = find_key_data(data, solvid, keyname, &key);
   if (!dp)
     return 0;
@@ -683,8 +799,17 @@ repodata_lookup_num(Repodata *data, Id solvid, Id keyname, unsigned int *value)
   unsigned char *dp;
   Repokey *key;
   KeyValue kv;
+  struct keycolumn *col;
 
   *value = 0;
+  if (data->keycolumns && (col = find_keycolumn(data, solvid, keyname)) != 0)
+    {
+      Id type = col->types[solvid - col->start];
+      if (type != REPOKEY_TYPE_NUM && type != REPOKEY_TYPE_U32 && type != REPOKEY_TYPE_CONSTANT)
+	return 0;
+      *value = col->values[solvid - col->start];
+      return 1;
+    }
   dp = find_key_data(data, solvid, keyname, &key);
   if (!dp)
     return 0;
@@ -732,6 +857,71 @@ repodata_lookup_bin_checksum(Repodata *data, Id solvid, Id keyname, Id *typep)
   return dp;
 }
 
+void
+repodata_create_keycolumn(Repodata *data, Id keyname)
+{
+  struct keycolumn *col;
+  Id p, type;
+  unsigned int num;
+  int i;
+
+  for (col = data->keycolumns; col; col = col->next)
+    if (col->keyname == keyname)
+      return;	/* already have it */
+  if (data->end <= data->start || !repodata_has_keyname(data, keyname))
+    return;
+  /* only keys with a fixed size value */
+  for (i = 1; i < data->nkeys; i++)
+    {
+      if (data->keys[i].name != keyname)
+	continue;
+      type = data->keys[i].type;
+      if (type != REPOKEY_TYPE_NUM && type != REPOKEY_TYPE_U32 && type != REPOKEY_TYPE_CONSTANT &&
+	  type != REPOKEY_TYPE_ID && type != REPOKEY_TYPE_CONSTANTID &&
+	  type != REPOKEY_TYPE_VOID && type != REPOKEY_TYPE_DELETED)
+	return;
+    }
+  col = solv_calloc(1, sizeof(*col));
+  col->keyname = keyname;
+  col->start = data->start;
+  col->end = data->end;
+  col->types = solv_calloc(data->end - data->start, sizeof(Id));
+  col->values = solv_calloc(data->end - data->start, sizeof(unsigned int));
+  for (p = data->start; p < data->end; p++)
+    {
+      type = repodata_lookup_type(data, p, keyname);
+      if (!type)
+	continue;
+      col->types[p - data->start] = type;
+      if (type == REPOKEY_TYPE_ID || type == REPOKEY_TYPE_CONSTANTID)
+	col->values[p - data->start] = repodata_lookup_id(data, p, keyname);
+      else if (repodata_lookup_num(data, p, keyname, &num))
+	col->values[p - data->start] = num;
+    }
+  if (data->state != REPODATA_AVAILABLE)
+    {
+      solv_free(col->types);
+      solv_free(col->values);
+      solv_free(col);
+      return;
+    }
+  col->next = data->keycolumns;
+  data->keycolumns = col;
+}
+
+void
+repodata_free_keycolumns(Repodata *data)
+{
+  struct keycolumn *col;
+  while ((col = data->keycolumns) != 0)
+    {
+      data->keycolumns = col->next;
+      solv_free(col->types);
+      solv_free(col->values);
+      solv_free(col);
+    }
+}
+
 int
 repodata_lookup_idarray(Repodata *data, Id solvid, Id keyname, Queue *q)
 {
@@ -894,7 +1084,10 @@ repodata_search(Repodata *data, Id solvid, Id keyname, int flags, int (*callback
 	  break;
       if (!*kp)
 	return;
-      dp = forward_to_key(data, *kp, keyp, dp);
+      if (solvid > 0)
+	dp = forward_to_keypos(data, solvid, keyp, kp - keyp, dp);
+      else
+	dp = forward_to_key(data, *kp, keyp, dp);
       if (!dp)
 	return;
       keyp = kp;
@@ -1036,6 +1229,140 @@ solvabledata_fetch(Solvable *s, KeyValue *kv, Id keyname)
     }
 }
 
+/* precompiled data for the non-regex matches */
+struct strmatchdata {
+  int mode;		/* SEARCH_STRING ... SEARCH_GLOB */
+  int nocase;
+  char *str;		/* the literal to search for */
+  int len;		/* its length */
+  int nseg;		/* glob with only '*' wildcards: number of segments in str */
+  int prefixlen;	/* glob for fnmatch: length of the literal prefix */
+};
+
+static inline int
+isglobchar(int c)
+{
+  return c == '*' || c == '?' || c == '[' || c == '\\';
+}
+
+static struct strmatchdata *
+strmatchdata_create(const char *match, int flags)
+{
+  struct strmatchdata *md;
+  const char *p;
+  int mode = flags & SEARCH_STRINGMASK;
+  int nocase = flags & SEARCH_NOCASE ? 1 : 0;
+  int l = strlen(match);
+
+  md = solv_calloc(1, sizeof(*md));
+  md->mode = mode;
+  md->nocase = nocase;
+  if (mode == SEARCH_GLOB)
+    {
+      int nstar = 0;
+      for (p = match; *p; p++)
+	{
+	  if (*p == '*')
+	    nstar++;
+	  else if (isglobchar(*p) || (nocase && (*p & 0x80) != 0))
+	    break;
+	}
+      if (!*p)
+	{
+	  /* only '*' wildcards, no need for fnmatch */
+	  const char *s = match, *e = match + l;
+	  if (nstar == 0)
+	    md->mode = SEARCH_STRING;
+	  else if (nstar == 1 && *s == '*')
+	    md->mode = SEARCH_STRINGEND, s++;
+	  else if (nstar == 1 && e[-1] == '*')
+	    md->mode = SEARCH_STRINGSTART, e--;
+	  else if (nstar == 2 && l > 1 && *s == '*' && e[-1] == '*')
+	    md->mode = SEARCH_SUBSTRING, s++, e--;
+	  else
+	    md->nseg = nstar + 1;
+	  match = s;
+	  l = e - s;
+	}
+      else
+	{
+	  /* need fnmatch, but we can check the literal prefix first */
+	  for (p = match; *p; p++)
+	    if (isglobchar(*p) || (nocase && (*p & 0x80) != 0))
+	      break;
+	  md->prefixlen = p - match;
+	}
+    }
+  md->str = solv_malloc(l + 1);
+  memcpy(md->str, match, l);
+  md->str[l] = 0;
+  md->len = l;
+  if (md->nseg)
+    {
+      /* split the glob into zero terminated segments */
+      char *sp;
+      for (sp = md->str; *sp; sp++)
+	if (*sp == '*')
+	  *sp = 0;
+    }
+  return md;
+}
+
+/* like strstr, but with optional case folding */
+static inline const char *
+findstr(const char *str, const char *s, int l, int nocase)
+{
+  int c, c0, c1;
+
+  if (!nocase)
+    return strstr(str, s);
+  if (!l)
+    return str;
+  /* scan for the first char, then compare the rest */
+  c0 = tolower(*(const unsigned char *)s);
+  c1 = toupper(c0);
+  for (; (c = *(const unsigned char *)str) != 0; str++)
+    if ((c == c0 || c == c1) && !strncasecmp(str + 1, s + 1, l - 1))
+      return str;
+  return 0;
+}
+
+/* match a glob that only contains '*' wildcards. The segments
+ * between the stars are searched from left to right, taking the
+ * first occurrence is always good enough. */
+static int
+starglob_match(struct strmatchdata *md, const char *str)
+{
+  const char *seg = md->str;
+  int i, l, sl, nocase = md->nocase;
+
+  /* first segment is anchored at the start */
+  l = strlen(seg);
+  if (l && (nocase ? strncasecmp(seg, str, l) : strncmp(seg, str, l)) != 0)
+    return 0;
+  str += l;
+  seg += l + 1;
+  for (i = 1; i < md->nseg - 1; i++)
+    {
+      l = strlen(seg);
+      if (l)
+	{
+	  if ((str = findstr(str, seg, l, nocase)) == 0)
+	    return 0;
+	  str += l;
+	}
+      seg += l + 1;
+    }
+  /* last segment is anchored at the end */
+  l = strlen(seg);
+  if (!l)
+    return 1;
+  sl = strlen(str);
+  if (sl < l)
+    return 0;
+  return (nocase ? strcasecmp(seg, str + sl - l) : strcmp(seg, str + sl - l)) == 0;
+}
+
 int
 datamatcher_init(Datamatcher *ma, const char *match, int flags)
 {
@@ -1049,10 +1376,12 @@ datamatcher_init(Datamatcher *ma, const char *match, int flags)
       ma->error = regcomp((regex_t *)ma->matchdata, match, REG_EXTENDED | REG_NOSUB | REG_NEWLINE | ((flags & SEARCH_NOCASE) ? REG_ICASE : 0));
       if (ma->error)
 	{
-	  solv_free(ma->matchdata);
+	  ma->matchdata = solv_free(ma->matchdata);
 	  ma->flags = (flags & ~SEARCH_STRINGMASK) | SEARCH_ERROR;
 	}
     }
+  else if (match && (flags & SEARCH_STRINGMASK) >= SEARCH_STRING && (flags & SEARCH_STRINGMASK) <= SEARCH_GLOB)
+    ma->matchdata = strmatchdata_create(match, flags);
   return ma->error;
 }
 
@@ -1064,71 +1393,80 @@ datamatcher_free(Datamatcher *ma)
       regfree(ma->matchdata);
       ma->matchdata = solv_free(ma->matchdata);
     }
+  else if (ma->matchdata)
+    {
+      struct strmatchdata *md = ma->matchdata;
+      solv_free(md->str);
+      ma->matchdata = solv_free(md);
+    }
 }
 
 int
 datamatcher_match(Datamatcher *ma, const char *str)
 {
   int l;
-  switch ((ma->flags & SEARCH_STRINGMASK))
+  struct strmatchdata *md;
+
+  if ((ma->flags & SEARCH_STRINGMASK) == SEARCH_REGEX)
+    {
+      if (regexec((const regex_t *)ma->matchdata, str, 0, NULL, 0))
+	return 0;
+      return 1;
+    }
+  md = ma->matchdata;
+  if (!md)
+    return 0;
+  switch (md->mode)
     {
     case SEARCH_SUBSTRING:
-      if (ma->flags & SEARCH_NOCASE)
-	{
-	  if (!strcasestr(str, ma->match))
-	    return 0;
-	}
-      else
-	{
-	  if (!strstr(str, ma->match))
-	    return 0;
-	}
+      if (!findstr(str, md->str, md->len, md->nocase))
+	return 0;
       break;
     case SEARCH_STRING:
-      if (ma->flags & SEARCH_NOCASE)
+      if (md->nocase)
 	{
-	  if (strcasecmp(ma->match, str))
+	  if (strcasecmp(md->str, str))
 	    return 0;
 	}
       else
 	{
-	  if (strcmp(ma->match, str))
+	  if (strcmp(md->str, str))
 	    return 0;
 	}
       break;
     case SEARCH_STRINGSTART:
-      if (ma->flags & SEARCH_NOCASE)
+      if (md->nocase)
 	{
-	  if (strncasecmp(ma->match, str, strlen(ma->match)))
+	  if (strncasecmp(md->str, str, md->len))
 	    return 0;
 	}
       else
 	{
-	  if (strncmp(ma->match, str, strlen(ma->match)))
+	  if (strncmp(md->str, str, md->len))
 	    return 0;
 	}
       break;
     case SEARCH_STRINGEND:
-      l = strlen(str) - strlen(ma->match);
+      l = strlen(str) - md->len;
       if (l < 0)
 	return 0;
-      if (ma->flags & SEARCH_NOCASE)
+      if (md->nocase)
 	{
-	  if (strcasecmp(ma->match, str + l))
+	  if (strcasecmp(md->str, str + l))
 	    return 0;
 	}
       else
 	{
-	  if (strcmp(ma->match, str + l))
+	  if (strcmp(md->str, str + l))
 	    return 0;
 	}
       break;
     case SEARCH_GLOB:
-      if (fnmatch(ma->match, str, (ma->flags & SEARCH_NOCASE) ? FNM_CASEFOLD : 0))
+      if (md->nseg)
+	return starglob_match(md, str);
+      if (md->prefixlen && (md->nocase ? strncasecmp(md->str, str, md->prefixlen) : strncmp(md->str, str, md->prefixlen)) != 0)
 	return 0;
-      break;
-    case SEARCH_REGEX:
-      if (regexec((const regex_t *)ma->matchdata, str, 0, NULL, 0))
+      if (fnmatch(md->str, str, md->nocase ? FNM_CASEFOLD : 0))
 	return 0;
       break;
     default:
@@ -1152,6 +1490,475 @@ repodata_filelistfilter_matches(Repodata *data, const char *str)
 }
 
 
+/* file list index: maps the hash of (dir, basename) to the solvables
+ * that may contain such a file. Hash collisions are not resolved, so
+ * the candidates still need to be checked. */
+struct filelistindex {
+  Hashmask mask;
+  Id *buckets;		/* hash -> offset into solvids */
+  Id *solvids;		/* sorted per bucket */
+  Hashmask dirmask;
+  Id *dirhashtbl;	/* (parent, comp) -> dir */
+  Id *dirparents;	/* dir -> parent dir */
+  char *lastfile;	/* cache for the last lookup */
+  Id lastbucket;
+};
+
+static inline Hashval
+filelistindex_hash(Id did, const char *name)
+{
+  return strhash_cont(name, did);
+}
+
+static inline Hashval
+filelistindex_dirhash(Id parent, Id comp)
+{
+  return (Hashval)parent * 31 + (Hashval)comp * 0x9e3779b1;
+}
+
+/* create the (parent, comp) -> dir hash used to resolve the directory
+ * of a lookup. We do not use the dirpool's own lookup data, as that
+ * would stay allocated after the index is gone. */
+static void
+filelistindex_create_dirhash(struct filelistindex *fi, Dirpool *dp)
+{
+  Id d, parent, *dirhashtbl, *dirparents;
+  Hashval h, hh;
+  Hashmask dirmask;
+
+  dirmask = mkmask(dp->ndirs + 1);
+  dirhashtbl = solv_calloc(dirmask + 1, sizeof(Id));
+  dirparents = solv_calloc(dp->ndirs + 1, sizeof(Id));
+  for (parent = 0, d = 2; d < dp->ndirs; d++)
+    {
+      if (dp->dirs[d] <= 0)
+	{
+	  parent = -dp->dirs[d];
+	  continue;
+	}
+      dirparents[d] = parent;
+      h = filelistindex_dirhash(parent, dp->dirs[d]) & dirmask;
+      hh = HASHCHAIN_START;
+      while (dirhashtbl[h])
+	h = HASHCHAIN_NEXT(h, hh, dirmask);
+      dirhashtbl[h] = d;
+    }
+  fi->dirmask = dirmask;
+  fi->dirhashtbl = dirhashtbl;
+  fi->dirparents = dirparents;
+}
+
+static int
+filelistindex_cb(void *cbdata, Solvable *s, Repodata *data, Repokey *key, KeyValue *kv)
+{
+  Queue *q = cbdata;
+  queue_push2(q, filelistindex_hash(kv->id, kv->str), s - data->repo->pool->solvables);
+  return 0;
+}
+
+void
+repodata_create_filelistindex(Repodata *data)
+{
+  Pool *pool = data->repo->pool;
+  struct filelistindex *fi;
+  Queue q;
+  Id p, *buckets, *solvids;
+  Hashmask mask;
+  int i, n;
+
+  repodata_free_filelistindex(data);
+  if (!repodata_has_keyname(data, SOLVABLE_FILELIST))
+    return;
+  queue_init(&q);
+  for (p = data->start; p < data->end; p++)
+    if (pool->solvables[p].repo == data->repo)
+      repodata_search(data, p, SOLVABLE_FILELIST, 0, filelistindex_cb, &q);
+  if (data->state != REPODATA_AVAILABLE)
+    {
+      queue_free(&q);
+      return;
+    }
+  /* one bucket per file is good enough, we check the candidates anyway */
+  mask = mkmask(q.count / 4 + 1);
+  buckets = solv_calloc(mask + 2, sizeof(Id));
+  for (i = 0; i < q.count; i += 2)
+    buckets[(q.elements[i] & mask) + 1]++;
+  for (i = 0; i <= mask; i++)
+    buckets[i + 1] += buckets[i];
+  /* the solvables are in ascending order, so the buckets get sorted */
+  solvids = solv_malloc2(q.count / 2 + 1, sizeof(Id));
+  for (i = 0; i < q.count; i += 2)
+    solvids[buckets[q.elements[i] & mask]++] = q.elements[i + 1];
+  for (i = mask; i >= 0; i--)
+    buckets[i + 1] = buckets[i];
+  buckets[0] = 0;
+  /* get rid of duplicates in the buckets */
+  for (i = 0, n = 0; i <= mask; i++)
+    {
+      int j, start = n;
+      for (j = buckets[i]; j < buckets[i + 1]; j++)
+	if (n == start || solvids[n - 1] != solvids[j])
+	  solvids[n++] = solvids[j];
+      buckets[i] = start;
+    }
+  buckets[mask + 1] = n;
+  queue_free(&q);
+  fi = solv_calloc(1, sizeof(*fi));
+  fi->mask = mask;
+  fi->buckets = buckets;
+  fi->solvids = solv_extend_resize(solvids, n, sizeof(Id), 1);
+  fi->lastbucket = -1;
+  filelistindex_create_dirhash(fi, &data->dirpool);
+  data->filelistindex = fi;
+}
+
+void
+repodata_free_filelistindex(Repodata *data)
+{
+  struct filelistindex *fi = data->filelistindex;
+  if (!fi)
+    return;
+  solv_free(fi->buckets);
+  solv_free(fi->solvids);
+  solv_free(fi->dirhashtbl);
+  solv_free(fi->dirparents);
+  solv_free(fi->lastfile);
+  data->filelistindex = solv_free(fi);
+}
+
+static Id
+filelistindex_finddir(struct filelistindex *fi, Dirpool *dp, Id parent, Id comp)
+{
+  Hashval h, hh;
+  Id d;
+
+  if (parent == 0 && comp == 1)
+    return 1;
+  h = filelistindex_dirhash(parent, comp) & fi->dirmask;
+  hh = HASHCHAIN_START;
+  while ((d = fi->dirhashtbl[h]) != 0)
+    {
+      if (dp->dirs[d] == comp && fi->dirparents[d] == parent)
+	return d;
+      h = HASHCHAIN_NEXT(h, hh, fi->dirmask);
+    }
+  return 0;
+}
+
+/* read-only version of repodata_str2dir: does not create the dircache
+ * or new dirs, returns 0 if the directory is not there */
+static Id
+filelistindex_lookup_dir(Repodata *data, const char *dir, int l)
+{
+  const char *dire, *end = dir + l;
+  Id id, parent = 0;
+
+  if (!data->dirpool.ndirs)
+    return 0;
+  while (dir + 1 < end && *dir == '/' && dir[1] == '/')
+    dir++;
+  if (*dir == '/' && dir + 1 == end)
+    return 1;
+  while (dir < end)
+    {
+      for (dire = dir; dire < end && *dire != '/'; dire++)
+	;
+      if (data->localpool)
+	id = stringpool_strn2id(&data->spool, dir, dire - dir, 0);
+      else
+	id = pool_strn2id(data->repo->pool, dir, dire - dir, 0);
+      if (!id)
+	return 0;
+      parent = filelistindex_finddir(data->filelistindex, &data->dirpool, parent, id);
+      if (!parent)
+	return 0;
+      dir = dire + 1;
+      while (dir < end && *dir == '/')
+	dir++;
+    }
+  return parent;
+}
+
+/* returns the number of solvables that may contain the file, -1 if
+ * there is no index. The solvables are sorted. */
+int
+repodata_filelistindex_lookup(Repodata *data, const char *file, Id **solvidsp)
+{
+  struct filelistindex *fi = data->filelistindex;
+  Id b;
+
+  *solvidsp = 0;
+  if (!fi)
+    return -1;
+  if (!fi->lastfile || strcmp(fi->lastfile, file) != 0)
+    {
+      const char *base = strrchr(file, '/');
+      Id did = 0;
+      if (base)
+	did = filelistindex_lookup_dir(data, file, base == file ? 1 : base - file);
+      fi->lastbucket = did ? filelistindex_hash(did, base + 1) & fi->mask : -1;
+      solv_free(fi->lastfile);
+      fi->lastfile = solv_strdup(file);
+    }
+  if (fi->lastbucket < 0)
+    return 0;
+  b = fi->lastbucket;
+  *solvidsp = fi->solvids + fi->buckets[b];
+  return fi->buckets[b + 1] - fi->buckets[b];
+}
+
+/* binary search in a sorted solvable list */
+static int
+solvids_contain(Id *solvids, int n, Id solvid)
+{
+  int lo = 0, hi = n, mid;
+  while (lo < hi)
+    {
+      mid = (lo + hi) / 2;
+      if (solvids[mid] == solvid)
+	return 1;
+      if (solvids[mid] < solvid)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return 0;
+}
+
+/* check if the solvable may contain the file according to the index */
+static int
+filelistindex_maycontain(Repodata *data, const char *file, Id solvid)
+{
+  Id *solvids;
+  int n;
+
+  n = repodata_filelistindex_lookup(data, file, &solvids);
+  if (n < 0)
+    return 1;
+  return solvids_contain(solvids, n, solvid);
+}
+
+
+/* string index: maps the (case folded) trigrams of the strings of a key
+ * to the solvables containing them. Substring searches only need to
+ * look at the solvables that contain all trigrams of the search string. */
+
+#define STRINGINDEX_MINBITS	8
+#define STRINGINDEX_MAXBITS	16
+
+struct stringindex {
+  struct stringindex *next;
+  Id keyname;
+  int bits;		/* log2 of the number of buckets */
+  Id *buckets;		/* trigram hash -> offset into solvids */
+  Id *solvids;		/* sorted per bucket */
+  /* cache for the last lookup */
+  char *laststr;
+  int laststrlen;
+  Id *cand;		/* sorted candidate solvables */
+  int ncand;
+};
+
+struct stringindex_cbdata {
+  int bits;
+  unsigned int ntrigrams;	/* sizing pass */
+  Id *lastsolv;
+  Id *buckets;		/* 0 in the sizing pass */
+  Id *solvids;		/* 0 in the counting pass */
+};
+
+static inline Id
+trigram_bucket(const unsigned char *s, int bits)
+{
+  unsigned int t = (unsigned int)tolower(s[0]) << 16 | (unsigned int)tolower(s[1]) << 8 | (unsigned int)tolower(s[2]);
+  return (t * 0x9e3779b1) >> (32 - bits);
+}
+
+static int
+stringindex_cb(void *cbdata, Solvable *s, Repodata *data, Repokey *key, KeyValue *kv)
+{
+  struct stringindex_cbdata *cbd = cbdata;
+  Id p = s - data->repo->pool->solvables;
+  const unsigned char *str;
+  Id b;
+
+  if (key->type == REPOKEY_TYPE_DELETED)
+    return 0;
+  if (!repodata_stringify(data->repo->pool, data, key, kv, 0))
+    return 0;
+  if (!cbd->buckets)
+    {
+      size_t l = strlen(kv->str);
+      if (l > 2)
+	cbd->ntrigrams += l - 2;
+      return 0;
+    }
+  for (str = (const unsigned char *)kv->str; str[0] && str[1] && str[2]; str++)
+    {
+      b = trigram_bucket(str, cbd->bits);
+      if (cbd->lastsolv[b] == p)
+	continue;
+      cbd->lastsolv[b] = p;
+      if (cbd->solvids)
+	cbd->solvids[cbd->buckets[b]++] = p;
+      else
+	cbd->buckets[b + 1]++;
+    }
+  return 0;
+}
+
+void
+repodata_create_stringindex(Repodata *data, Id keyname)
+{
+  Pool *pool = data->repo->pool;
+  struct stringindex *si, **sip;
+  struct stringindex_cbdata cbd;
+  int nbuckets;
+  Id p;
+  int i;
+
+  for (sip = &data->stringindex; (si = *sip) != 0; sip = &si->next)
+    if (si->keyname == keyname)
+      break;
+  if (si)
+    return;	/* already have it */
+  if (keyname >= SOLVABLE_NAME && keyname <= RPM_RPMDBID)
+    return;	/* stored in the solvable, not in the repodata */
+  if (!repodata_has_keyname(data, keyname))
+    return;
+  for (i = 1; i < data->nkeys; i++)
+    if (data->keys[i].name == keyname && (data->keys[i].type == REPOKEY_TYPE_FIXARRAY || data->keys[i].type == REPOKEY_TYPE_FLEXARRAY))
+      return;	/* the strings are in the sub-structures */
+  memset(&cbd, 0, sizeof(cbd));
+  /* sizing pass: about one bucket per trigram */
+  for (p = data->start; p < data->end; p++)
+    if (pool->solvables[p].repo == data->repo)
+      repodata_search(data, p, keyname, 0, stringindex_cb, &cbd);
+  if (data->state != REPODATA_AVAILABLE)
+    return;
+  for (cbd.bits = STRINGINDEX_MINBITS; cbd.bits < STRINGINDEX_MAXBITS; cbd.bits++)
+    if ((1U << cbd.bits) >= cbd.ntrigrams)
+      break;
+  nbuckets = 1 << cbd.bits;
+  cbd.lastsolv = solv_calloc(nbuckets, sizeof(Id));
+  cbd.buckets = solv_calloc(nbuckets + 1, sizeof(Id));
+  /* first pass: count */
+  for (p = data->start; p < data->end; p++)
+    if (pool->solvables[p].repo == data->repo)
+      repodata_search(data, p, keyname, 0, stringindex_cb, &cbd);
+  if (data->state != REPODATA_AVAILABLE)
+    {
+      solv_free(cbd.lastsolv);
+      solv_free(cbd.buckets);
+      return;
+    }
+  for (i = 0; i < nbuckets; i++)
+    cbd.buckets[i + 1] += cbd.buckets[i];
+  /* second pass: fill */
+  cbd.solvids = solv_malloc2(cbd.buckets[nbuckets] + 1, sizeof(Id));
+  memset(cbd.lastsolv, 0, nbuckets * sizeof(Id));
+  for (p = data->start; p < data->end; p++)
+    if (pool->solvables[p].repo == data->repo)
+      repodata_search(data, p, keyname, 0, stringindex_cb, &cbd);
+  for (i = nbuckets - 1; i >= 0; i--)
+    cbd.buckets[i + 1] = cbd.buckets[i];
+  cbd.buckets[0] = 0;
+  solv_free(cbd.lastsolv);
+  si = solv_calloc(1, sizeof(*si));
+  si->keyname = keyname;
+  si->bits = cbd.bits;
+  si->buckets = cbd.buckets;
+  si->solvids = cbd.solvids;
+  *sip = si;
+}
+
+void
+repodata_free_stringindex(Repodata *data)
+{
+  struct stringindex *si;
+  while ((si = data->stringindex) != 0)
+    {
+      data->stringindex = si->next;
+      solv_free(si->buckets);
+      solv_free(si->solvids);
+      solv_free(si->laststr);
+      solv_free(si->cand);
+      solv_free(si);
+    }
+}
+
+/* intersect the sorted candidates with the solvables of bucket b */
+static void
+stringindex_intersect(struct stringindex *si, Id b)
+{
+  Id *bs = si->solvids + si->buckets[b];
+  int bn = si->buckets[b + 1] - si->buckets[b];
+  int i, j, n;
+
+  if (si->ncand < 0)
+    {
+      si->cand = solv_malloc2(bn + 1, sizeof(Id));
+      memcpy(si->cand, bs, bn * sizeof(Id));
+      si->ncand = bn;
+      return;
+    }
+  for (i = j = n = 0; i < si->ncand && j < bn; )
+    {
+      if (si->cand[i] < bs[j])
+	i++;
+      else if (si->cand[i] > bs[j])
+	j++;
+      else
+	{
+	  si->cand[n++] = si->cand[i++];
+	  j++;
+	}
+    }
+  si->ncand = n;
+}
+
+/* check if the solvable may contain a string matching the matcher
+ * according to the index */
+static int
+stringindex_maycontain(Repodata *data, Id keyname, Datamatcher *ma, Id solvid)
+{
+  struct stringindex *si;
+  struct strmatchdata *md;
+  int i;
+
+  if ((ma->flags & SEARCH_STRINGMASK) == SEARCH_REGEX)
+    return 1;	/* matchdata is the compiled regex */
+  md = ma->matchdata;
+  if (!md || (md->mode == SEARCH_GLOB && !md->nseg))
+    return 1;	/* fnmatch */
+  for (si = data->stringindex; si; si = si->next)
+    if (si->keyname == keyname)
+      break;
+  if (!si)
+    return 1;
+  if (!si->laststr || si->laststrlen != md->len || memcmp(si->laststr, md->str, md->len) != 0)
+    {
+      /* new search string, intersect the solvables of all trigrams.
+       * the segments of a glob are zero separated, so no trigram
+       * will span two segments */
+      si->cand = solv_free(si->cand);
+      si->ncand = -1;
+      for (i = 0; i + 2 < md->len; i++)
+	{
+	  const unsigned char *str = (const unsigned char *)md->str + i;
+	  if (str[0] && str[1] && str[2])
+	    stringindex_intersect(si, trigram_bucket(str, si->bits));
+	}
+      solv_free(si->laststr);
+      si->laststr = solv_malloc(md->len + 1);
+      memcpy(si->laststr, md->str, md->len + 1);
+      si->laststrlen = md->len;
+    }
+  if (si->ncand < 0)
+    return 1;	/* no trigram in the search string */
+  return solvids_contain(si->cand, si->ncand, solvid);
+}
+
 enum {
   di_bye,
 
@@ -1378,6 +2185,19 @@ dataiterator_step(Dataiterator *di)
 	    }
 	  if (di->repodataid && di->keyname == SOLVABLE_FILELIST && !dataiterator_filelistcheck(di))
 	    goto di_nextrepodata;
+	  if (di->data->filelistindex && di->keyname == SOLVABLE_FILELIST && di->solvid > 0 && di->matcher.match && (di->matcher.flags & (SEARCH_FILES|SEARCH_NOCASE|SEARCH_STRINGMASK)) == (SEARCH_FILES|SEARCH_STRING))
+	    {
+	      /* exact file match, ask the index */
+	      if (!filelistindex_maycontain(di->data, di->matcher.match, di->solvid))
+		goto di_nextrepodata;
+	    }
+	  if (di->data->stringindex && di->keyname && !di->nkeynames && di->solvid > 0 && di->matcher.match && !(di->matcher.flags & (SEARCH_FILES|SEARCH_CHECKSUMS)) && !(di->flags & SEARCH_SUB))
+	    {
+	      /* ask the string index if we can skip this solvable. It only
+	       * knows the top level strings, so it can't be used for SEARCH_SUB */
+	      if (!stringindex_maycontain(di->data, di->keyname, &di->matcher, di->solvid))
+		goto di_nextrepodata;
+	    }
 	  if (!maybe_load_repodata(di->data, di->keyname))
 	    goto di_nextrepodata;
 	  di->dp = solvid2data(di->data, di->solvid, &schema);
@@ -1845,28 +2665,17 @@ repodata_extend(Repodata *data, Id p)
 void
 repodata_shrink(Repodata *data, int end)
 {
-  int i;
-
   if (data->end <= end)
     return;
   if (data->start >= end)
     {
-      if (data->attrs)
-	{
-	  for (i = 0; i < data->end - data->start; i++)
-	    solv_free(data->attrs[i]);
-          data->attrs = solv_free(data->attrs);
-	}
+      data->attrs = solv_free(data->attrs);
       data->incoreoffset = solv_free(data->incoreoffset);
       data->start = data->end = 0;
       return;
     }
   if (data->attrs)
-    {
-      for (i = end; i < data->end; i++)
-	solv_free(data->attrs[i - data->start]);
-      data->attrs = solv_extend_resize(data->attrs, end - data->start, sizeof(Id *), REPODATA_BLOCK);
-    }
+    data->attrs = solv_extend_resize(data->attrs, end - data->start, sizeof(Id *), REPODATA_BLOCK);
   if (data->incoreoffset)
     data->incoreoffset = solv_extend_resize(data->incoreoffset, end - data->start, sizeof(Id), REPODATA_BLOCK);
   data->end = end;
@@ -1894,10 +2703,49 @@ repodata_extend_block(Repodata *data, Id start, Id num)
 
 
 #define REPODATA_ATTRS_BLOCK 31
-#define REPODATA_ATTRDATA_BLOCK 1023
-#define REPODATA_ATTRIDDATA_BLOCK 63
+#define REPODATA_ATTRDATA_BLOCK 16383
+#define REPODATA_ATTRIDDATA_BLOCK 4095
 #define REPODATA_ATTRNUM64DATA_BLOCK 15
 
+#define ATTRARENA_CHUNK 65536
+
+/* the attrs/xattrs key lists are allocated from an arena, as they are
+ * all thrown away together in repodata_internalize */
+struct attrarena {
+  struct attrarena *next;
+  int used;
+  int size;
+  Id *mem;
+};
+
+static Id *
+attrarena_alloc(Repodata *data, int n)
+{
+  struct attrarena *ar = data->attrarena;
+  if (!ar || ar->used + n > ar->size)
+    {
+      ar = solv_calloc(1, sizeof(*ar));
+      ar->size = n > ATTRARENA_CHUNK ? n : ATTRARENA_CHUNK;
+      ar->mem = solv_malloc2(ar->size, sizeof(Id));
+      ar->next = data->attrarena;
+      data->attrarena = ar;
+    }
+  ar->used += n;
+  return ar->mem + ar->used - n;
+}
+
+static void
+repodata_free_attrarena(Repodata *data)
+{
+  struct attrarena *ar;
+  while ((ar = data->attrarena) != 0)
+    {
+      data->attrarena = ar->next;
+      solv_free(ar->mem);
+      solv_free(ar);
+    }
+}
+
 
 Id
 repodata_new_handle(Repodata *data)
@@ -1959,8 +2807,14 @@ repodata_insert_keyid(Repodata *data, Id handle, Id keyid, Id val, int overwrite
         }
       i = pp - ap;
     }
-  ap = solv_extend(ap, i, 3, sizeof(Id), REPODATA_ATTRS_BLOCK);
-  *app = ap;
+  if (!ap || ((i - 1) | REPODATA_ATTRS_BLOCK) != ((i + 2) | REPODATA_ATTRS_BLOCK))
+    {
+      /* no room, move to a bigger block */
+      pp = attrarena_alloc(data, (i + 3 + REPODATA_ATTRS_BLOCK) & ~REPODATA_ATTRS_BLOCK);
+      if (i)
+	memcpy(pp, ap, i * sizeof(Id));
+      *app = ap = pp;
+    }
   pp = ap + i;
   *pp++ = keyid;
   *pp++ = val;
@@ -2460,7 +3314,7 @@ repodata_swap_attrs(Repodata *data, Id dest, Id src)
 
 /* TODO: unify with repo_write and repo_solv! */
 
-#define EXTDATA_BLOCK 1023
+#define EXTDATA_BLOCK 16383
 
 struct extdata {
   unsigned char *buf;
@@ -2703,9 +3557,18 @@ repodata_internalize(Repodata *data)
   struct extdata newvincore;
   Id solvkeyid;
 
+  /* the dir lookup hash is only needed while adding dirs */
+  dirpool_free_dirhash(&data->dirpool);
   if (!data->attrs && !data->xattrs)
     return;
 
+  /* the cached key positions, disk usage and indices are no longer valid */
+  data->nlastkeyoffsets = 0;
+  repodata_free_ducache(data);
+  repodata_free_filelistindex(data);
+  repodata_free_stringindex(data);
+  repodata_free_keycolumns(data);
+
   newvincore.buf = data->vincore;
   newvincore.len = data->vincorelen;
 
@@ -2865,14 +3728,12 @@ fprintf(stderr, "schemadata %p\n", data->schemadata);
 	  dp = ndp;
 	}
       if (entry >= 0 && data->attrs && data->attrs[entry])
-	data->attrs[entry] = solv_free(data->attrs[entry]);
+	data->attrs[entry] = 0;
     }
   /* free all xattrs */
-  for (entry = 0; entry < data->nxattrs; entry++)
-    if (data->xattrs[entry])
-      solv_free(data->xattrs[entry]);
   data->xattrs = solv_free(data->xattrs);
   data->nxattrs = 0;
+  repodata_free_attrarena(data);
 
   data->lasthandle = 0;
   data->lastkey = 0;
@@ -44,6 +44,21 @@ typedef struct _Repokey {
 
 #ifdef LIBSOLV_INTERNAL
 struct dircache;
+
+/* per repodata cache of the disk usage of the solvables, aggregated
+ * by mount point. It is filled by pool_calc_duchanges() and is valid
+ * as long as the repodata does not change and the same mount points
+ * are used. */
+struct ducache {
+  char *mpkey;		/* the mount points the cache was created for */
+  int mpkeyl;
+  Id *dirmap;		/* dir -> mount point */
+  int ndirmap;
+  Id *offsets;		/* solvable - start -> offset into dudata, 0: not yet computed */
+  int noffsets;
+  Id *dudata;		/* (mount point + 1, kbytes, files) triples, 0 terminated */
+  int ndudata;
+};
 #endif
 
 typedef struct _Repodata {
@@ -82,6 +97,7 @@ typedef struct _Repodata {
 
   unsigned int schemadatalen;   /* schema storage size */
   Id *schematahash;		/* unification helper */
+  Hashmask schematahashmask;	/* its mask */
 
   unsigned char *incoredata;	/* in-core data */
   unsigned int incoredatalen;	/* in-core data used */
@@ -92,6 +108,10 @@ typedef struct _Repodata {
 
   Id *incoreoffset;		/* offset for all entries */
 
+  Id lastkeysolvid;		/* solvable of the key position cache */
+  Id *lastkeyoffsets;		/* key positions of that solvable */
+  int nlastkeyoffsets;		/* number of known key positions */
+
   Id *verticaloffset;		/* offset for all verticals, nkeys elements */
   Id lastverticaloffset;	/* end of verticals */
 
@@ -111,6 +131,8 @@ typedef struct _Repodata {
   unsigned long long *attrnum64data;	/* their 64bit num data space */
   unsigned int attrnum64datalen;	/* its len */
 
+  struct attrarena *attrarena;	/* storage of the attrs/xattrs key lists */
+
   /* array cache to speed up repodata_add functions*/
   Id lasthandle;
   Id lastkey;
@@ -118,6 +140,18 @@ typedef struct _Repodata {
 
   /* directory cache to speed up repodata_str2dir */
   struct dircache *dircache;
+
+  /* disk usage cache to speed up pool_calc_duchanges */
+  struct ducache *ducache;
+
+  /* optional index to speed up file lookups */
+  struct filelistindex *filelistindex;
+
+  /* optional indices to speed up substring searches */
+  struct stringindex *stringindex;
+
+  /* optional per solvable arrays of fixed size keys */
+  struct keycolumn *keycolumns;
 #endif
 
 } Repodata;
@@ -196,6 +230,25 @@ int repodata_stringify(Pool *pool, Repodata *data, Repokey *key, struct _KeyValu
 
 int repodata_filelistfilter_matches(Repodata *data, const char *str);
 
+/* index the file list so that searches for a file and
+ * pool_addfileprovides only need to look at matching solvables.
+ * The index is dropped if the data changes. */
+void repodata_create_filelistindex(Repodata *data);
+void repodata_free_filelistindex(Repodata *data);
+int repodata_filelistindex_lookup(Repodata *data, const char *file, Id **solvidsp);
+
+/* index the trigrams of the strings of a key, so that string
+ * searches only need to look at solvables that may match.
+ * The index is dropped if the data changes. */
+void repodata_create_stringindex(Repodata *data, Id keyname);
+void repodata_free_stringindex(Repodata *data);
+
+/* cache the values of a num or id key in a dense array indexed by
+ * solvable, so that lookups of the key do not need to decode the data.
+ * The cache is dropped if the data changes. */
+void repodata_create_keycolumn(Repodata *data, Id keyname);
+void repodata_free_keycolumns(Repodata *data);
+
 
 /* lookup functions */
 Id repodata_lookup_type(Repodata *data, Id solvid, Id keyname);
@@ -254,6 +307,7 @@ void repodata_set_idarray(Repodata *data, Id solvid, Id keyname, Queue *q);
 void repodata_add_dirnumnum(Repodata *data, Id solvid, Id keyname, Id dir, Id num, Id num2);
 void repodata_add_dirstr(Repodata *data, Id solvid, Id keyname, Id dir, const char *str);
 void repodata_free_dircache(Repodata *data);
+void repodata_free_ducache(Repodata *data);
 
 
 /* Arrays */
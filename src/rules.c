@@ -756,50 +756,118 @@ solver_addrpmrulesforsolvable(Solver *solv, Solvable *s, Map *m)
  * m: already added solvables
  */
 
-void
-solver_addrpmrulesforweak(Solver *solv, Map *m)
+static inline int
+weakdep_possible(Solver *solv, Solvable *s, Map *m)
 {
-  Pool *pool = solv->pool;
-  Solvable *s;
   Id sup, *supp;
-  int i, n;
 
-  /* foreach solvable in pool */
-  for (i = n = 1; n < pool->nsolvables; i++, n++)
+  if (s->supplements)
     {
-      if (i == pool->nsolvables)		/* wrap i */
-	i = 1;
-      if (MAPTST(m, i))				/* already added that one */
-	continue;
+      /* find possible supplements */
+      supp = s->repo->idarraydata + s->supplements;
+      while ((sup = *supp++) != 0)
+	if (dep_possible(solv, sup, m))
+	  return 1;
+    }
+  /* if nothing found, check for enhances */
+  if (s->enhances)
+    {
+      supp = s->repo->idarraydata + s->enhances;
+      while ((sup = *supp++) != 0)
+	if (dep_possible(solv, sup, m))
+	  return 1;
+    }
+  return 0;
+}
 
-      s = pool->solvables + i;
-      if (!pool_installable(pool, s))		/* only look at installable ones */
+static inline void
+weakdep_pushcandidates(Pool *pool, Id name, Map *m, Queue *q, Map *qm)
+{
+  Id p, *pp;
+  for (pp = pool_whatdeps_ptr(pool, SOLVABLE_SUPPLEMENTS, name); (p = *pp) != 0; pp++)
+    if (!MAPTST(m, p) && !MAPTST(qm, p))
+      {
+	MAPSET(qm, p);
+	queue_push(q, p);
+      }
+  for (pp = pool_whatdeps_ptr(pool, SOLVABLE_ENHANCES, name); (p = *pp) != 0; pp++)
+    if (!MAPTST(m, p) && !MAPTST(qm, p))
+      {
+	MAPSET(qm, p);
+	queue_push(q, p);
+      }
+}
+
+/*
+ * find the solvables that got added to m since the last call
+ * and queue all packages that supplement or enhance one of their
+ * names, as only those can have become possible.
+ */
+static void
+weakdep_newcandidates(Solver *solv, Map *m, Map *oldm, Queue *q, Map *qm)
+{
+  Pool *pool = solv->pool;
+  Solvable *s;
+  Id p, prv, *prvp;
+  Map newm;
+
+  /* m only grows, so the new solvables are m & ~oldm */
+  map_init_clone(&newm, m);
+  map_subtract(&newm, oldm);
+  for (p = map_next(&newm, 0); p >= 0; p = map_next(&newm, p + 1))
+    {
+      s = pool->solvables + p;
+      weakdep_pushcandidates(pool, s->name, m, q, qm);
+      if (!s->provides)
 	continue;
+      prvp = s->repo->idarraydata + s->provides;
+      while ((prv = *prvp++) != 0)
+	weakdep_pushcandidates(pool, prv, m, q, qm);
+    }
+  /* dependencies not indexed by name */
+  if (map_next(&newm, 0) >= 0)
+    weakdep_pushcandidates(pool, 0, m, q, qm);
+  map_or(oldm, &newm);
+  map_free(&newm);
+}
 
-      sup = 0;
-      if (s->supplements)
-	{
-	  /* find possible supplements */
-	  supp = s->repo->idarraydata + s->supplements;
-	  while ((sup = *supp++) != 0)
-	    if (dep_possible(solv, sup, m))
-	      break;
-	}
+void
+solver_addrpmrulesforweak(Solver *solv, Map *m)
+{
+  Pool *pool = solv->pool;
+  Solvable *s;
+  Queue q;
+  Map qm, oldm;
+  Id p;
+  int i;
 
-      /* if nothing found, check for enhances */
-      if (!sup && s->enhances)
+  /* first check all solvables, then the packages that may have
+   * become possible because we added rules for some solvables */
+  queue_init(&q);
+  map_init(&qm, pool->nsolvables);
+  map_init_clone(&oldm, m);
+  for (p = 1; p < pool->nsolvables; p++)
+    queue_push(&q, p);
+  while (q.count)
+    {
+      for (i = 0; i < q.count; i++)
 	{
-	  supp = s->repo->idarraydata + s->enhances;
-	  while ((sup = *supp++) != 0)
-	    if (dep_possible(solv, sup, m))
-	      break;
+	  p = q.elements[i];
+	  MAPCLR(&qm, p);
+	  if (MAPTST(m, p))			/* already added that one */
+	    continue;
+	  s = pool->solvables + p;
+	  if (!pool_installable(pool, s))	/* only look at installable ones */
+	    continue;
+	  if (weakdep_possible(solv, s, m))
+	    solver_addrpmrulesforsolvable(solv, s, m);
 	}
-      /* if nothing found, goto next solvables */
-      if (!sup)
-	continue;
-      solver_addrpmrulesforsolvable(solv, s, m);
-      n = 0;			/* check all solvables again because we added solvables to m */
+      queue_empty(&q);
+      weakdep_newcandidates(solv, m, &oldm, &q, &qm);
     }
+  map_free(&oldm);
+  map_free(&qm);
+  queue_free(&q);
 }
 
 
@@ -2073,6 +2141,65 @@ solver_ruleliterals(Solver *solv, Id rid, Queue *q)
     queue_push(q, -SYSTEMSOLVABLE);	/* hmm, better to return an empty result? */
 }
 
+static inline Id
+rulecomponents_find(Id *parent, Id p)
+{
+  while (parent[p] != p)
+    p = parent[p] = parent[parent[p]];
+  return p;
+}
+
+/*
+ * split the packages of the rules into independent components, i.e.
+ * sets of packages that are not connected by any rule. The rules of
+ * different components don't interact, so each component could be
+ * solved on its own.
+ * q gets the component number of each solvable, 0 if the solvable is
+ * not part of any rule. Returns the number of components.
+ */
+int
+solver_rulecomponents(Solver *solv, Queue *q)
+{
+  Pool *pool = solv->pool;
+  Id p, *pp, root, first, *parent;
+  Rule *r;
+  int i, ncomp = 0;
+
+  queue_empty(q);
+  queue_insertn(q, 0, pool->nsolvables);
+  parent = solv_calloc(pool->nsolvables, sizeof(Id));
+  for (i = 0; i < pool->nsolvables; i++)
+    parent[i] = i;
+  for (i = 1, r = solv->rules + i; i < solv->nrules; i++, r++)
+    {
+      first = 0;
+      FOR_RULELITERALS(p, pp, r)
+	{
+	  p = p > 0 ? p : -p;
+	  if (p == SYSTEMSOLVABLE)
+	    continue;
+	  q->elements[p] = -1;		/* part of a rule */
+	  root = rulecomponents_find(parent, p);
+	  if (!first)
+	    first = root;
+	  else if (root != first)
+	    parent[root] = first;
+	}
+    }
+  /* number the components */
+  for (p = 1; p < pool->nsolvables; p++)
+    {
+      if (!q->elements[p])
+	continue;
+      root = rulecomponents_find(parent, p);
+      if (q->elements[root] < 0)
+	q->elements[root] = ++ncomp;
+      q->elements[p] = q->elements[root];
+    }
+  solv_free(parent);
+  return ncomp;
+}
+
 int
 solver_rule2jobidx(Solver *solv, Id rid)
 {
@@ -2341,66 +2468,76 @@ dep_pkgcheck(Solver *solv, Id dep, Map *m, Queue *q)
 }
 
 /*
- * Find all installed packages that are no longer
- * needed regarding the current solver job.
- *
- * The algorithm is:
- * - remove pass: remove all packages that could have
- *   been dragged in by the obsoleted packages.
- *   i.e. if package A is obsolete and contains "Requires: B",
- *   also remove B, as installing A will have pulled in B.
- *   after this pass, we have a set of still installed packages
- *   with broken dependencies.
- * - add back pass:
- *   now add back all packages that the still installed packages
- *   require.
- *
- * The cleandeps packages are the packages removed in the first
- * pass and not added back in the second pass.
- *
- * If we search for unneeded packages (unneeded is true), we
- * simply remove all packages except the userinstalled ones in
- * the first pass.
+ * The dependency graph of the installed packages does not depend
+ * on the job, so we create it once and keep it in the solver.
+ * Layout of the cleandeps_graph queue (n = number of installed solvables):
+ *   [0..n-1]  offset of the dependency list of the installed solvable
+ *   [n]       offset of the list of installed solvables with supplements
+ * A dependency list contains the installed providers of the requires,
+ * a zero, the installed providers of the recommends and another zero.
+ * We also remember the installed patterns and products, as they
+ * are always treated as userinstalled.
  */
 static void
-solver_createcleandepsmap(Solver *solv, Map *cleandepsmap, int unneeded)
+cleandeps_adddeps(Solver *solv, Solvable *s, Queue *q)
 {
   Pool *pool = solv->pool;
   Repo *installed = solv->installed;
-  Queue *job = &solv->job;
-  Map userinstalled;
-  Map im;
-  Map installedm;
-  Rule *r;
-  Id rid, how, what, select;
-  Id p, pp, ip, *jp;
-  Id req, *reqp, sup, *supp;
-  Solvable *s;
-  Queue iq;
-  int i;
-
-  map_empty(cleandepsmap);
-  if (!installed || installed->end == installed->start)
-    return;
-  map_init(&userinstalled, installed->end - installed->start);
-  map_init(&im, pool->nsolvables);
-  map_init(&installedm, pool->nsolvables);
-  queue_init(&iq);
+  Id p, pp, req, *reqp;
 
-  for (i = 0; i < job->count; i += 2)
+  if (s->requires)
     {
-      how = job->elements[i];
-      if ((how & SOLVER_JOBMASK) == SOLVER_USERINSTALLED)
+      reqp = s->repo->idarraydata + s->requires;
+      while ((req = *reqp++) != 0)
 	{
-	  what = job->elements[i + 1];
-	  select = how & SOLVER_SELECTMASK;
-	  FOR_JOB_SELECT(p, pp, select, what)
+	  if (req == SOLVABLE_PREREQMARKER)
+	    continue;
+	  FOR_PROVIDES(p, pp, req)
 	    if (pool->solvables[p].repo == installed)
-	      MAPSET(&userinstalled, p - installed->start);
+	      queue_push(q, p);
 	}
     }
+  queue_push(q, 0);
+  if (s->recommends)
+    {
+      reqp = s->repo->idarraydata + s->recommends;
+      while ((req = *reqp++) != 0)
+	FOR_PROVIDES(p, pp, req)
+	  if (pool->solvables[p].repo == installed)
+	    queue_push(q, p);
+    }
+  queue_push(q, 0);
+}
 
-  /* also add visible patterns to userinstalled for openSUSE */
+static void
+cleandeps_creategraph(Solver *solv)
+{
+  Pool *pool = solv->pool;
+  Repo *installed = solv->installed;
+  Queue *q;
+  Id p, pp;
+  Solvable *s;
+  int n = installed->end - installed->start;
+
+  q = solv->cleandeps_graph = solv_calloc(1, sizeof(Queue));
+  queue_init(q);
+  queue_insertn(q, 0, n + 1);
+  for (p = installed->start; p < installed->end; p++)
+    {
+      s = pool->solvables + p;
+      if (s->repo != installed)
+	continue;
+      q->elements[p - installed->start] = q->count;
+      cleandeps_adddeps(solv, s, q);
+    }
+  q->elements[n] = q->count;
+  for (p = installed->start; p < installed->end; p++)
+    if (pool->solvables[p].repo == installed && pool->solvables[p].supplements)
+      queue_push(q, p);
+  queue_push(q, 0);
+
+  map_init(&solv->cleandeps_pinned, n);
+  /* visible patterns are userinstalled for openSUSE */
   if (1)
     {
       Dataiterator di;
@@ -2424,7 +2561,7 @@ solver_createcleandepsmap(Solver *solv, Map *cleandepsmap, int unneeded)
 		{
 		  if (strncmp(pool_id2str(pool, pool->solvables[p].name), "pattern", 7) != 0)
 		    continue;
-		  MAPSET(&userinstalled, p - installed->start);
+		  MAPSET(&solv->cleandeps_pinned, p - installed->start);
 		}
 	}
       dataiterator_free(&di);
@@ -2434,22 +2571,111 @@ solver_createcleandepsmap(Solver *solv, Map *cleandepsmap, int unneeded)
       /* all products and their buddies are userinstalled */
       for (p = installed->start; p < installed->end; p++)
 	{
-	  Solvable *s = pool->solvables + p;
+	  s = pool->solvables + p;
 	  if (s->repo != installed)
 	    continue;
 	  if (!strncmp("product:", pool_id2str(pool, s->name), 8))
 	    {
-	      MAPSET(&userinstalled, p - installed->start);
+	      MAPSET(&solv->cleandeps_pinned, p - installed->start);
 	      if (pool->nscallback)
 		{
 		  Id buddy = pool->nscallback(pool, pool->nscallbackdata, NAMESPACE_PRODUCTBUDDY, p);
 		  if (buddy >= installed->start && buddy < installed->end && pool->solvables[buddy].repo == installed)
-		    MAPSET(&userinstalled, buddy);
+		    MAPSET(&solv->cleandeps_pinned, buddy);
 		}
 	    }
 	}
     }
-  
+}
+
+void
+solver_freecleandepsgraph(Solver *solv)
+{
+  if (!solv->cleandeps_graph)
+    return;
+  queue_free(solv->cleandeps_graph);
+  solv->cleandeps_graph = solv_free(solv->cleandeps_graph);
+  map_free(&solv->cleandeps_pinned);
+}
+
+/* return the dependency list of a solvable, see cleandeps_creategraph */
+static inline Id *
+cleandeps_deps(Solver *solv, Id p, Queue *tmpq)
+{
+  Repo *installed = solv->installed;
+  Solvable *s = solv->pool->solvables + p;
+
+  if (s->repo == installed)
+    return solv->cleandeps_graph->elements + solv->cleandeps_graph->elements[p - installed->start];
+  queue_empty(tmpq);
+  cleandeps_adddeps(solv, s, tmpq);
+  return tmpq->elements;
+}
+
+/*
+ * Find all installed packages that are no longer
+ * needed regarding the current solver job.
+ *
+ * The algorithm is:
+ * - remove pass: remove all packages that could have
+ *   been dragged in by the obsoleted packages.
+ *   i.e. if package A is obsolete and contains "Requires: B",
+ *   also remove B, as installing A will have pulled in B.
+ *   after this pass, we have a set of still installed packages
+ *   with broken dependencies.
+ * - add back pass:
+ *   now add back all packages that the still installed packages
+ *   require.
+ *
+ * The cleandeps packages are the packages removed in the first
+ * pass and not added back in the second pass.
+ *
+ * If we search for unneeded packages (unneeded is true), we
+ * simply remove all packages except the userinstalled ones in
+ * the first pass.
+ */
+static void
+solver_createcleandepsmap(Solver *solv, Map *cleandepsmap, int unneeded)
+{
+  Pool *pool = solv->pool;
+  Repo *installed = solv->installed;
+  Queue *job = &solv->job;
+  Map userinstalled;
+  Map im;
+  Map installedm;
+  Rule *r;
+  Id rid, how, what, select;
+  Id p, pp, ip, *jp;
+  Id sup, *supp, *dp, *suppkgs;
+  Solvable *s;
+  Queue iq, depq;
+  int i;
+
+  map_empty(cleandepsmap);
+  if (!installed || installed->end == installed->start)
+    return;
+  if (!solv->cleandeps_graph)
+    cleandeps_creategraph(solv);
+  suppkgs = solv->cleandeps_graph->elements + solv->cleandeps_graph->elements[installed->end - installed->start];
+  map_init_clone(&userinstalled, &solv->cleandeps_pinned);	/* patterns and products */
+  map_init(&im, pool->nsolvables);
+  map_init(&installedm, pool->nsolvables);
+  queue_init(&iq);
+  queue_init(&depq);
+
+  for (i = 0; i < job->count; i += 2)
+    {
+      how = job->elements[i];
+      if ((how & SOLVER_JOBMASK) == SOLVER_USERINSTALLED)
+	{
+	  what = job->elements[i + 1];
+	  select = how & SOLVER_SELECTMASK;
+	  FOR_JOB_SELECT(p, pp, select, what)
+	    if (pool->solvables[p].repo == installed)
+	      MAPSET(&userinstalled, p - installed->start);
+	}
+    }
+
   /* add all positive elements (e.g. locks) to "userinstalled" */
   for (rid = solv->jobrules; rid < solv->jobrules_end; rid++)
     {
@@ -2581,13 +2807,9 @@ solver_createcleandepsmap(Solver *solv, Map *cleandepsmap, int unneeded)
 	  if (unneeded)
 	    break;
 	  /* supplements pass */
-	  for (ip = solv->installed->start; ip < solv->installed->end; ip++)
+	  for (dp = suppkgs; (ip = *dp) != 0; dp++)
 	    {
-	      if (!MAPTST(&installedm, ip))
-		continue;
 	      s = pool->solvables + ip;
-	      if (!s->supplements)
-		continue;
 	      if (!MAPTST(&im, ip))
 		continue;
 	      if (MAPTST(&userinstalled, ip - installed->start))
@@ -2635,57 +2857,26 @@ solver_createcleandepsmap(Solver *solv, Map *cleandepsmap, int unneeded)
 #ifdef CLEANDEPSDEBUG
       printf("removing %s\n", pool_solvable2str(pool, s));
 #endif
-      if (s->requires)
+      /* requires */
+      for (dp = cleandeps_deps(solv, ip, &depq); (p = *dp) != 0; dp++)
 	{
-	  reqp = s->repo->idarraydata + s->requires;
-	  while ((req = *reqp++) != 0)
+	  if (MAPTST(&im, p))
 	    {
-	      if (req == SOLVABLE_PREREQMARKER)
-		continue;
-#if 0
-	      /* count number of installed packages that match */
-	      count = 0;
-	      FOR_PROVIDES(p, pp, req)
-		if (MAPTST(&installedm, p))
-		  count++;
-	      if (count > 1)
-		continue;
-#endif
-	      FOR_PROVIDES(p, pp, req)
-		{
-		  if (MAPTST(&im, p))
-		    {
 #ifdef CLEANDEPSDEBUG
-		      printf("%s requires %s\n", pool_solvid2str(pool, ip), pool_solvid2str(pool, p));
+	      printf("%s requires %s\n", pool_solvid2str(pool, ip), pool_solvid2str(pool, p));
 #endif
-		      queue_push(&iq, p);
-		    }
-		}
+	      queue_push(&iq, p);
 	    }
 	}
-      if (s->recommends)
+      /* recommends */
+      for (dp++; (p = *dp) != 0; dp++)
 	{
-	  reqp = s->repo->idarraydata + s->recommends;
-	  while ((req = *reqp++) != 0)
+	  if (MAPTST(&im, p))
 	    {
-#if 0
-	      count = 0;
-	      FOR_PROVIDES(p, pp, req)
-		if (MAPTST(&installedm, p))
-		  count++;
-	      if (count > 1)
-		continue;
-#endif
-	      FOR_PROVIDES(p, pp, req)
-		{
-		  if (MAPTST(&im, p))
-		    {
 #ifdef CLEANDEPSDEBUG
-		      printf("%s recommends %s\n", pool_solvid2str(pool, ip), pool_solvid2str(pool, p));
+	      printf("%s recommends %s\n", pool_solvid2str(pool, ip), pool_solvid2str(pool, p));
 #endif
-		      queue_push(&iq, p);
-		    }
-		}
+	      queue_push(&iq, p);
 	    }
 	}
     }
@@ -2736,15 +2927,11 @@ solver_createcleandepsmap(Solver *solv, Map *cleandepsmap, int unneeded)
       if (!iq.count)
 	{
 	  /* supplements pass */
-	  for (ip = installed->start; ip < installed->end; ip++)
+	  for (dp = suppkgs; (ip = *dp) != 0; dp++)
 	    {
-	      if (!MAPTST(&installedm, ip))
-		continue;
 	      if (MAPTST(&userinstalled, ip - installed->start))
 	        continue;
 	      s = pool->solvables + ip;
-	      if (!s->supplements)
-		continue;
 	      if (MAPTST(&im, ip))
 		continue;
 	      supp = s->repo->idarraydata + s->supplements;
@@ -2768,53 +2955,42 @@ solver_createcleandepsmap(Solver *solv, Map *cleandepsmap, int unneeded)
 #ifdef CLEANDEPSDEBUG
       printf("adding back %s\n", pool_solvable2str(pool, s));
 #endif
-      if (s->requires)
+      /* requires */
+      for (dp = cleandeps_deps(solv, ip, &depq); (p = *dp) != 0; dp++)
 	{
-	  reqp = s->repo->idarraydata + s->requires;
-	  while ((req = *reqp++) != 0)
+	  if (!MAPTST(&im, p) && MAPTST(&installedm, p))
 	    {
-	      FOR_PROVIDES(p, pp, req)
-		{
-		  if (!MAPTST(&im, p) && MAPTST(&installedm, p))
-		    {
-		      if (p == ip)
-			continue;
-		      if (MAPTST(&userinstalled, p - installed->start))
-			continue;
+	      if (p == ip)
+		continue;
+	      if (MAPTST(&userinstalled, p - installed->start))
+		continue;
 #ifdef CLEANDEPSDEBUG
-		      printf("%s requires %s\n", pool_solvid2str(pool, ip), pool_solvid2str(pool, p));
+	      printf("%s requires %s\n", pool_solvid2str(pool, ip), pool_solvid2str(pool, p));
 #endif
-		      MAPSET(&im, p);
-		      queue_push(&iq, p);
-		    }
-		}
+	      MAPSET(&im, p);
+	      queue_push(&iq, p);
 	    }
 	}
-      if (s->recommends)
+      /* recommends */
+      for (dp++; (p = *dp) != 0; dp++)
 	{
-	  reqp = s->repo->idarraydata + s->recommends;
-	  while ((req = *reqp++) != 0)
+	  if (!MAPTST(&im, p) && MAPTST(&installedm, p))
 	    {
-	      FOR_PROVIDES(p, pp, req)
-		{
-		  if (!MAPTST(&im, p) && MAPTST(&installedm, p))
-		    {
-		      if (p == ip)
-			continue;
-		      if (MAPTST(&userinstalled, p - installed->start))
-			continue;
+	      if (p == ip)
+		continue;
+	      if (MAPTST(&userinstalled, p - installed->start))
+		continue;
 #ifdef CLEANDEPSDEBUG
-		      printf("%s recommends %s\n", pool_solvid2str(pool, ip), pool_solvid2str(pool, p));
+	      printf("%s recommends %s\n", pool_solvid2str(pool, ip), pool_solvid2str(pool, p));
 #endif
-		      MAPSET(&im, p);
-		      queue_push(&iq, p);
-		    }
-		}
+	      MAPSET(&im, p);
+	      queue_push(&iq, p);
 	    }
 	}
     }
     
   queue_free(&iq);
+  queue_free(&depq);
   if (solv->cleandeps_updatepkgs)
     for (i = 0; i < solv->cleandeps_updatepkgs->count; i++)
       MAPSET(&im, solv->cleandeps_updatepkgs->elements[i]);
@@ -2911,6 +3087,7 @@ solver_get_unneeded(Solver *solv, Queue *unneededq, int filtered)
       Pool *pool = solv->pool;
       Queue edges;
       Id *nrequires;
+      Id *nodeidx;
       Map installedm;
       int j, pass, count = unneededq->count;
       Id *low;
@@ -2921,6 +3098,10 @@ solver_get_unneeded(Solver *solv, Queue *unneededq, int filtered)
 	  MAPSET(&installedm, i);
 
       nrequires = solv_calloc(count, sizeof(Id));
+      /* map installed solvable to node number + 1 */
+      nodeidx = solv_calloc(installed->end - installed->start, sizeof(Id));
+      for (i = 0; i < count; i++)
+	nodeidx[unneededq->elements[i] - installed->start] = i + 1;
       queue_init(&edges);
       /* pre-size */
       queue_insertn(&edges, 0, count * 4 + 10);
@@ -2942,32 +3123,24 @@ solver_get_unneeded(Solver *solv, Queue *unneededq, int filtered)
       /* first requires and recommends */
       for (i = 0; i < count; i++)
 	{
-	  Solvable *s = pool->solvables + unneededq->elements[i];
+	  Id *dp = cleandeps_deps(solv, unneededq->elements[i], 0);
 	  edges.elements[i + 1] = edges.count;
-	  for (pass = 0; pass < 2; pass++)
+	  for (pass = 0; pass < 2; pass++, dp++)
 	    {
 	      int num = 0;
-	      unsigned int off = pass == 0 ? s->requires : s->recommends;
-	      Id p, pp, *dp;
-	      if (off)
-		for (dp = s->repo->idarraydata + off; *dp; dp++)
-		  FOR_PROVIDES(p, pp, *dp)
-		    {
-		      Solvable *sp = pool->solvables + p;
-		      if (s == sp || sp->repo != installed || !MAPTST(&cleandepsmap, p - installed->start))
-			continue;
-		      for (j = 0; j < count; j++)
-			if (p == unneededq->elements[j])
-			  break;
-		      if (j == count)
-			continue;
-		      if (num && edges.elements[edges.count - 1] == j + 1)
-			continue;
-		      queue_push(&edges, j + 1);
-		      num++;
-		    }
-		if (pass == 0)
-		  nrequires[i] = num;
+	      Id p;
+	      for (; (p = *dp) != 0; dp++)
+		{
+		  if (p == unneededq->elements[i] || !MAPTST(&cleandepsmap, p - installed->start))
+		    continue;
+		  j = nodeidx[p - installed->start] - 1;
+		  if (num && edges.elements[edges.count - 1] == j + 1)
+		    continue;
+		  queue_push(&edges, j + 1);
+		  num++;
+		}
+	      if (pass == 0)
+		nrequires[i] = num;
 	    }
 	  queue_push(&edges, 0);
 	}
@@ -3003,9 +3176,7 @@ solver_get_unneeded(Solver *solv, Queue *unneededq, int filtered)
 			Solvable *sp = pool->solvables + p;
 			if (p == unneededq->elements[i] || sp->repo != installed || !MAPTST(&cleandepsmap, p - installed->start))
 			  continue;
-			for (j = 0; j < count; j++)
-			  if (p == unneededq->elements[j])
-			    break;
+			j = nodeidx[p - installed->start] - 1;
 			/* now add edge from j + 1 to i + 1 */
 			queue_insert(&edges, edges.elements[j + 1] + nrequires[j], i + 1);
 			/* addapt following edge pointers */
@@ -3080,6 +3251,7 @@ solver_get_unneeded(Solver *solv, Queue *unneededq, int filtered)
 	}
       solv_free(low);
       solv_free(nrequires);
+      solv_free(nodeidx);
       queue_free(&edges);
 
       /* finally remove all pruned entries from unneededq */
@@ -130,6 +130,7 @@ extern SolverRuleinfo solver_ruleclass(struct _Solver *solv, Id rid);
 extern void solver_ruleliterals(struct _Solver *solv, Id rid, Queue *q);
 extern int  solver_rule2jobidx(struct _Solver *solv, Id rid);
 extern Id   solver_rule2job(struct _Solver *solv, Id rid, Id *whatp);
+extern int  solver_rulecomponents(struct _Solver *solv, Queue *q);
 
 
 #ifdef __cplusplus
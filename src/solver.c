@@ -598,6 +598,7 @@ propagate(Solver *solv, int level)
 	 * negate because our watches trigger if literal goes FALSE
 	 */
       pkg = -solv->decisionq.elements[solv->propagate_index++];
+      solv->stats_propagations++;
 	
       IF_POOLDEBUG (SOLV_DEBUG_PROPAGATE)
         {
@@ -758,6 +759,58 @@ propagate(Solver *solv, int level)
 /********************************************************************/
 /* Analysis */
 
+/*-------------------------------------------------------------------
+ * 
+ * activity heuristic helpers
+ *
+ * solvables involved in conflicts get their activity bumped, the bump
+ * grows with every conflict so that old conflicts count less.
+ */
+
+static void
+bumpactivity(Solver *solv, Id v)
+{
+  Pool *pool = solv->pool;
+  int i;
+
+  if (v < 0)
+    v = -v;
+  solv->activity[v] += solv->activityinc;
+  if (solv->activity[v] < 0x40000000)
+    return;
+  /* rescale to avoid overflows */
+  for (i = 1; i < pool->nsolvables; i++)
+    solv->activity[i] >>= 20;
+  solv->activityinc = (solv->activityinc >> 20) + 1;
+}
+
+/* stable sort of the candidates: saved phase first, then activity */
+static void
+activitysort(Solver *solv, Queue *dq)
+{
+  unsigned int *activity = solv->activity;
+  Map *phasemap = &solv->phasemap;
+  int i, j, phase;
+  Id p, q;
+
+  for (i = 1; i < dq->count; i++)
+    {
+      p = dq->elements[i];
+      phase = MAPTST(phasemap, p) ? 1 : 0;
+      for (j = i; j > 0; j--)
+	{
+	  q = dq->elements[j - 1];
+	  if ((MAPTST(phasemap, q) ? 1 : 0) > phase)
+	    break;
+	  if ((MAPTST(phasemap, q) ? 1 : 0) == phase && activity[q] >= activity[p])
+	    break;
+	  dq->elements[j] = q;
+	}
+      dq->elements[j] = p;
+    }
+}
+
+
 /*-------------------------------------------------------------------
  * 
  * analyze
@@ -862,6 +915,15 @@ l1retry:
     }
   map_free(&seen);
 
+  if (solv->activity)
+    {
+      /* bump the activity of the literals of the learnt rule */
+      bumpactivity(solv, *pr);
+      for (i = 0; i < r.count; i++)
+	bumpactivity(solv, r.elements[i]);
+      solv->activityinc += (solv->activityinc >> 4) + 1;	/* decay old activity */
+    }
+
   if (r.count == 0)
     *dr = 0;
   else if (r.count == 1 && r.elements[0] < 0)
@@ -881,6 +943,7 @@ l1retry:
     *whyp = learnt_why;
   queue_free(&r);
   solv->stats_learned++;
+  solv->stats_conflicts++;
   return rlevel;
 }
 
@@ -1163,6 +1226,14 @@ revert(Solver *solv, int level)
       if (solv->decisionmap[vv] <= level && solv->decisionmap[vv] >= -level)
         break;
       POOL_DEBUG(SOLV_DEBUG_PROPAGATE, "reverting decision %d at %d\n", v, solv->decisionmap[vv]);
+      if (solv->phasemap.size)
+	{
+	  /* remember the phase so that we can choose the same again */
+	  if (v > 0)
+	    MAPSET(&solv->phasemap, vv);
+	  else
+	    MAPCLR(&solv->phasemap, vv);
+	}
       solv->decisionmap[vv] = 0;
       solv->decisionq.count--;
       solv->decisionq_why.count--;
@@ -1245,6 +1316,8 @@ setpropagatelearn(Solver *solv, int level, Id decision, int disablerules, Id rul
   for (;;)
     {
       r = propagate(solv, level);
+      if (solv->budget_active && solver_budget_exhausted(solv))
+	return 0;
       if (!r)
 	break;
       if (level == 1)
@@ -1281,6 +1354,9 @@ setpropagatelearn(Solver *solv, int level, Id decision, int disablerules, Id rul
 	  POOL_DEBUG(SOLV_DEBUG_ANALYZE, "new rule: ");
 	  solver_printrule(solv, SOLV_DEBUG_ANALYZE, r);
 	}
+      /* check the conflict budget now, not after the next propagation */
+      if (solv->budget_conflicts && solver_budget_exhausted(solv))
+	return 0;
     }
   return level;
 }
@@ -1320,6 +1396,8 @@ selectandinstall(Solver *solv, int level, Queue *dq, int disablerules, Id ruleid
 	    break;
 	  }
     }
+  if (dq->count > 1 && solv->activity)
+    activitysort(solv, dq);
   if (dq->count > 1)
     {
       /* multiple candidates, open a branch */
@@ -1424,6 +1502,7 @@ solver_free(Solver *solv)
       queue_free(solv->cleandeps_mistakes);
       solv->cleandeps_mistakes = solv_free(solv->cleandeps_mistakes);
     }
+  solver_freecleandepsgraph(solv);
 
   map_free(&solv->recommendsmap);
   map_free(&solv->suggestsmap);
@@ -1445,6 +1524,8 @@ solver_free(Solver *solv)
   solv_free(solv->obsoletes_data);
   solv_free(solv->multiversionupdaters);
   solv_free(solv->choicerules_ref);
+  solv_free(solv->activity);
+  map_free(&solv->phasemap);
   solv_free(solv);
 }
 
@@ -1473,6 +1554,8 @@ solver_get_flag(Solver *solv, int flag)
     return solv->addalreadyrecommended;
   case SOLVER_FLAG_NO_INFARCHCHECK:
     return solv->noinfarchcheck;
+  case SOLVER_FLAG_ACTIVITY_HEURISTIC:
+    return solv->activityheuristic;
   default:
     break;
   }
@@ -1515,12 +1598,114 @@ solver_set_flag(Solver *solv, int flag, int value)
   case SOLVER_FLAG_NO_INFARCHCHECK:
     solv->noinfarchcheck = value;
     break;
+  case SOLVER_FLAG_ACTIVITY_HEURISTIC:
+    solv->activityheuristic = value;
+    break;
   default:
     break;
   }
   return old;
 }
 
+int
+solver_get_budget(Solver *solv, int budget)
+{
+  switch (budget)
+  {
+  case SOLVER_BUDGET_PROPAGATIONS:
+    return solv->budget_propagations;
+  case SOLVER_BUDGET_CONFLICTS:
+    return solv->budget_conflicts;
+  case SOLVER_BUDGET_TIME:
+    return solv->budget_time;
+  default:
+    break;
+  }
+  return -1;
+}
+
+static inline void
+solver_update_budget_active(Solver *solv)
+{
+  solv->budget_active = solv->budget_propagations || solv->budget_conflicts || solv->budget_time || solv->abortcallback;
+}
+
+/* set a limit for solver_solve and the solution creation, 0 means no limit */
+int
+solver_set_budget(Solver *solv, int budget, int value)
+{
+  int old = solver_get_budget(solv, budget);
+  if (value < 0)
+    value = 0;
+  switch (budget)
+  {
+  case SOLVER_BUDGET_PROPAGATIONS:
+    solv->budget_propagations = value;
+    break;
+  case SOLVER_BUDGET_CONFLICTS:
+    solv->budget_conflicts = value;
+    break;
+  case SOLVER_BUDGET_TIME:
+    solv->budget_time = value;
+    break;
+  default:
+    break;
+  }
+  solver_update_budget_active(solv);
+  return old;
+}
+
+/* the callback gets called from time to time, returning true aborts the solver */
+void
+solver_set_abortcallback(Solver *solv, int (*cb)(Solver *solv, void *data), void *data)
+{
+  solv->abortcallback = cb;
+  solv->abortcallbackdata = data;
+  solver_update_budget_active(solv);
+}
+
+/* true if the last solver_solve or solution creation ran out of budget */
+int
+solver_aborted(Solver *solv)
+{
+  return solv->aborted;
+}
+
+void
+solver_start_budget(Solver *solv)
+{
+  solv->aborted = 0;
+  solv->stats_propagations = 0;
+  solv->stats_conflicts = 0;
+  solv->budget_nextcheck = 0;
+  solv->budget_start = solv->budget_time ? solv_timems(0) : 0;
+}
+
+int
+solver_budget_exhausted(Solver *solv)
+{
+  Pool *pool = solv->pool;
+
+  if (solv->aborted)
+    return 1;
+  if (solv->budget_propagations && solv->stats_propagations >= solv->budget_propagations)
+    solv->aborted = 1;
+  else if (solv->budget_conflicts && solv->stats_conflicts >= solv->budget_conflicts)
+    solv->aborted = 1;
+  else if ((solv->budget_time || solv->abortcallback) && solv->stats_propagations >= solv->budget_nextcheck)
+    {
+      /* do the more expensive checks only every 256 propagations */
+      solv->budget_nextcheck = solv->stats_propagations + 256;
+      if (solv->budget_time && solv_timems(solv->budget_start) >= (unsigned int)solv->budget_time)
+	solv->aborted = 1;
+      else if (solv->abortcallback && solv->abortcallback(solv, solv->abortcallbackdata))
+	solv->aborted = 1;
+    }
+  if (solv->aborted)
+    POOL_DEBUG(SOLV_DEBUG_STATS, "solver aborted after %d propagations and %d conflicts\n", solv->stats_propagations, solv->stats_conflicts);
+  return solv->aborted;
+}
+
 int
 cleandeps_check_mistakes(Solver *solv, int level)
 {
@@ -1576,6 +1761,58 @@ cleandeps_check_mistakes(Solver *solv, int level)
   return mademistake;
 }
 
+/*
+ * update the map of packages that may be supplemented. A package that
+ * was not supplemented at the last check can only have become
+ * supplemented if it supplements a name provided by a newly installed
+ * package. Packages found not to be supplemented are cleared from the
+ * map by the caller.
+ */
+static void
+update_supplementscheck(Solver *solv, Map *checkmap, Map *installedmap, Queue *installedq)
+{
+  Pool *pool = solv->pool;
+  Solvable *s;
+  Id p, *pp, prv, *prvp;
+  int i, j;
+
+  if (!checkmap->size)
+    {
+      map_init(checkmap, pool->nsolvables);
+      map_init(installedmap, pool->nsolvables);
+    }
+  /* forget packages that got reverted */
+  for (i = j = 0; i < installedq->count; i++)
+    {
+      p = installedq->elements[i];
+      if (solv->decisionmap[p] > 0)
+	installedq->elements[j++] = p;
+      else
+	MAPCLR(installedmap, p);
+    }
+  queue_truncate(installedq, j);
+  for (i = 0; i < solv->decisionq.count; i++)
+    {
+      p = solv->decisionq.elements[i];
+      if (p < 0 || MAPTST(installedmap, p))
+	continue;
+      MAPSET(installedmap, p);
+      queue_push(installedq, p);
+      s = pool->solvables + p;
+      for (pp = pool_whatdeps_ptr(pool, SOLVABLE_SUPPLEMENTS, s->name); *pp; pp++)
+	MAPSET(checkmap, *pp);
+      if (!s->provides)
+	continue;
+      prvp = s->repo->idarraydata + s->provides;
+      while ((prv = *prvp++) != 0)
+	for (pp = pool_whatdeps_ptr(pool, SOLVABLE_SUPPLEMENTS, prv); *pp; pp++)
+	  MAPSET(checkmap, *pp);
+    }
+  /* supplements not indexed by name are always checked */
+  for (pp = pool_whatdeps_ptr(pool, SOLVABLE_SUPPLEMENTS, 0); *pp; pp++)
+    MAPSET(checkmap, *pp);
+}
+
 /*-------------------------------------------------------------------
  * 
  * solver_run_sat
@@ -1589,6 +1826,10 @@ solver_run_sat(Solver *solv, int disablerules, int doweak)
 {
   Queue dq;		/* local decisionqueue */
   Queue dqs;		/* local decisionqueue for supplements */
+  Id dqbuf[32], dqsbuf[32];
+  Map suppcheckmap;	/* packages that may be supplemented */
+  Map suppinstalledmap;	/* installed packages at the last check */
+  Queue suppinstalledq;
   int systemlevel;
   int level, olevel;
   Rule *r;
@@ -1598,6 +1839,7 @@ solver_run_sat(Solver *solv, int disablerules, int doweak)
   Id p, *dp;
   int minimizationsteps;
   int installedpos = solv->installed ? solv->installed->start : 0;
+  int restartinterval, nextrestart;
 
   IF_POOLDEBUG (SOLV_DEBUG_RULE_CREATION)
     {
@@ -1613,8 +1855,20 @@ solver_run_sat(Solver *solv, int disablerules, int doweak)
   systemlevel = level + 1;
   POOL_DEBUG(SOLV_DEBUG_SOLVER, "solving...\n");
 
-  queue_init(&dq);
-  queue_init(&dqs);
+  queue_init_buffer(&dq, dqbuf, sizeof(dqbuf)/sizeof(*dqbuf));
+  queue_init_buffer(&dqs, dqsbuf, sizeof(dqsbuf)/sizeof(*dqsbuf));
+  map_init(&suppcheckmap, 0);
+  map_init(&suppinstalledmap, 0);
+  queue_init(&suppinstalledq);
+
+  if (solv->activityheuristic && !solv->activity)
+    {
+      solv->activity = solv_calloc(pool->nsolvables, sizeof(unsigned int));
+      solv->activityinc = 1;
+      map_init(&solv->phasemap, pool->nsolvables);
+    }
+  restartinterval = 100;
+  nextrestart = solv->stats_learned + restartinterval;
 
   /*
    * here's the main loop:
@@ -1631,13 +1885,34 @@ solver_run_sat(Solver *solv, int disablerules, int doweak)
   minimizationsteps = 0;
   for (;;)
     {
+      /*
+       * restart from level 1 every now and then when using the activity
+       * heuristic. we keep the learnt rules and the saved phases, so this
+       * is cheap and lets us make better choices at the lower levels.
+       */
+      if (solv->activity && level > 1 && solv->stats_learned >= nextrestart && !solv->solution_callback)
+	{
+	  POOL_DEBUG(SOLV_DEBUG_SOLVER, "restarting after %d learnt rules\n", solv->stats_learned);
+	  restartinterval += restartinterval / 2;
+	  nextrestart = solv->stats_learned + restartinterval;
+	  level = 1;
+	  revert(solv, level);
+	  systemlevel = level + 1;
+	}
+
       /*
        * initial propagation of the assertions
        */
       if (level == 1)
 	{
 	  POOL_DEBUG(SOLV_DEBUG_PROPAGATE, "propagating (propagate_index: %d;  size decisionq: %d)...\n", solv->propagate_index, solv->decisionq.count);
-	  if ((r = propagate(solv, level)) != 0)
+	  r = propagate(solv, level);
+	  if (solv->budget_active && solver_budget_exhausted(solv))
+	    {
+	      level = 0;
+	      break;	/* aborted */
+	    }
+	  if (r)
 	    {
 	      if (analyze_unsolvable(solv, r, disablerules))
 		continue;
@@ -1803,6 +2078,9 @@ solver_run_sat(Solver *solv, int disablerules, int doweak)
 			{
 			  queue_free(&dq);
 			  queue_free(&dqs);
+			  map_free(&suppcheckmap);
+			  map_free(&suppinstalledmap);
+			  queue_free(&suppinstalledq);
 			  return;
 			}
 		      if (level <= olevel)
@@ -1960,6 +2238,7 @@ solver_run_sat(Solver *solv, int disablerules, int doweak)
 	  POOL_DEBUG(SOLV_DEBUG_POLICY, "installing recommended packages\n");
 	  queue_empty(&dq);	/* recommended packages */
 	  queue_empty(&dqs);	/* supplemented packages */
+	  update_supplementscheck(solv, &suppcheckmap, &suppinstalledmap, &suppinstalledq);
 	  for (i = 1; i < pool->nsolvables; i++)
 	    {
 	      if (solv->decisionmap[i] < 0)
@@ -1997,13 +2276,14 @@ solver_run_sat(Solver *solv, int disablerules, int doweak)
 		}
 	      else
 		{
-		  s = pool->solvables + i;
-		  if (!s->supplements)
-		    continue;
-		  if (!pool_installable(pool, s))
-		    continue;
-		  if (!solver_is_supplementing(solv, s))
+		  if (!MAPTST(&suppcheckmap, i))
 		    continue;
+		  s = pool->solvables + i;
+		  if (!s->supplements || !pool_installable(pool, s) || !solver_is_supplementing(solv, s))
+		    {
+		      MAPCLR(&suppcheckmap, i);
+		      continue;
+		    }
 		  if (solv->dupmap_all && solv->installed && s->repo == solv->installed && (solv->droporphanedmap_all || (solv->droporphanedmap.size && MAPTST(&solv->droporphanedmap, i - solv->installed->start))))
 		    continue;
 		  queue_push(&dqs, i);
@@ -2349,6 +2629,9 @@ solver_run_sat(Solver *solv, int disablerules, int doweak)
   POOL_DEBUG(SOLV_DEBUG_STATS, "done solving.\n\n");
   queue_free(&dq);
   queue_free(&dqs);
+  map_free(&suppcheckmap);
+  map_free(&suppinstalledmap);
+  queue_free(&suppinstalledq);
   if (level == 0)
     {
       /* unsolvable */
@@ -2507,6 +2790,74 @@ weaken_solvable_deps(Solver *solv, Id p)
 /********************************************************************/
 /* main() */
 
+/*
+ * reset everything a previous solver_solve run created, so that
+ * the solver can be used again (e.g. after running out of budget)
+ */
+static void
+solver_free_solvedata(Solver *solv)
+{
+  Pool *pool = solv->pool;
+
+  queue_empty(&solv->ruletojob);
+  queue_empty(&solv->decisionq);
+  queue_empty(&solv->decisionq_why);
+  queue_empty(&solv->problems);
+  queue_empty(&solv->solutions);
+  queue_empty(&solv->orphaned);
+  queue_empty(&solv->learnt_why);
+  queue_empty(&solv->learnt_pool);
+  queue_push(&solv->learnt_pool, 0);	/* so that 0 does not describe a proof */
+  queue_empty(&solv->branches);
+  queue_empty(&solv->weakruleq);
+  queue_empty(&solv->ruleassertions);
+  solv->propagate_index = 0;
+  solv->stats_learned = solv->stats_unsolvable = 0;
+
+  solv->nrules = 1;
+  solv->rpmrules_end = 0;		/* solver_addrule checks this */
+  solv->featurerules = solv->featurerules_end = 0;
+  solv->updaterules = solv->updaterules_end = 0;
+  solv->jobrules = solv->jobrules_end = 0;
+  solv->infarchrules = solv->infarchrules_end = 0;
+  solv->duprules = solv->duprules_end = 0;
+  solv->choicerules = solv->choicerules_end = 0;
+  solv->learntrules = 0;
+  solv->watches = solv_free(solv->watches);
+  solv->obsoletes = solv_free(solv->obsoletes);
+  solv->obsoletes_data = solv_free(solv->obsoletes_data);
+  solv->obsoletes_generation = 0;
+  solv->multiversionupdaters = solv_free(solv->multiversionupdaters);
+  solv->choicerules_ref = solv_free(solv->choicerules_ref);
+
+  /* the pool may have grown since the last run */
+  solv_free(solv->decisionmap);
+  solv->decisionmap = (Id *)solv_calloc(pool->nsolvables, sizeof(Id));
+  map_free(&solv->recommendsmap);
+  map_init(&solv->recommendsmap, pool->nsolvables);
+  map_free(&solv->suggestsmap);
+  map_init(&solv->suggestsmap, pool->nsolvables);
+  solv->recommends_index = 0;
+  map_free(&solv->noupdate);
+  map_init(&solv->noupdate, solv->installed ? solv->installed->end - solv->installed->start : 0);
+  map_free(&solv->weakrulemap);
+  map_free(&solv->noobsoletes);
+
+  map_free(&solv->updatemap);
+  solv->updatemap_all = 0;
+  map_free(&solv->fixmap);
+  solv->fixmap_all = 0;
+  map_free(&solv->dupmap);
+  map_free(&solv->dupinvolvedmap);
+  solv->dupmap_all = 0;
+  map_free(&solv->droporphanedmap);
+  solv->droporphanedmap_all = 0;
+  map_free(&solv->cleandepsmap);
+  solver_freecleandepsgraph(solv);
+  solv->activity = solv_free(solv->activity);
+  map_free(&solv->phasemap);
+}
+
 
 void
 solver_calculate_noobsmap(Pool *pool, Queue *job, Map *noobsmap)
@@ -2572,6 +2923,10 @@ solver_solve(Solver *solv, Queue *job)
   POOL_DEBUG(SOLV_DEBUG_STATS, "obsoleteusesprovides=%d, implicitobsoleteusesprovides=%d, obsoleteusescolors=%d\n", pool->obsoleteusesprovides, pool->implicitobsoleteusesprovides, pool->obsoleteusescolors);
   POOL_DEBUG(SOLV_DEBUG_STATS, "dontinstallrecommended=%d, addalreadyrecommended=%d\n", solv->dontinstallrecommended, solv->addalreadyrecommended);
 
+  /* free old stuff in case we re-run a solver */
+  solver_free_solvedata(solv);
+  solver_start_budget(solv);
+
   /* create whatprovides if not already there */
   if (!pool->whatprovides)
     pool_createwhatprovides(pool);
@@ -2708,14 +3063,10 @@ solver_solve(Solver *solv, Queue *job)
 
   IF_POOLDEBUG (SOLV_DEBUG_STATS)
     {
-      int possible = 0, installable = 0;
+      int possible = map_count(&addedmap), installable = 0;
       for (i = 1; i < pool->nsolvables; i++)
-	{
-	  if (pool_installable(pool, pool->solvables + i))
-	    installable++;
-	  if (MAPTST(&addedmap, i))
-	    possible++;
-	}
+	if (pool_installable(pool, pool->solvables + i))
+	  installable++;
       POOL_DEBUG(SOLV_DEBUG_STATS, "%d of %d installable solvables considered for solving\n", possible, installable);
     }
 
@@ -3019,6 +3370,21 @@ solver_solve(Solver *solv, Queue *job)
 
   POOL_DEBUG(SOLV_DEBUG_STATS, "%d rpm rules, 2 * %d update rules, %d job rules, %d infarch rules, %d dup rules, %d choice rules\n", solv->rpmrules_end - 1, solv->updaterules_end - solv->updaterules, solv->jobrules_end - solv->jobrules, solv->infarchrules_end - solv->infarchrules, solv->duprules_end - solv->duprules, solv->choicerules_end - solv->choicerules);
   POOL_DEBUG(SOLV_DEBUG_STATS, "overall rule memory used: %d K\n", solv->nrules * (int)sizeof(Rule) / 1024);
+  IF_POOLDEBUG (SOLV_DEBUG_STATS)
+    {
+      int ncomp, largest = 0;
+      Id *compsize;
+      Queue cq;
+      queue_init(&cq);
+      ncomp = solver_rulecomponents(solv, &cq);
+      compsize = solv_calloc(ncomp + 1, sizeof(Id));
+      for (i = 1; i < cq.count; i++)
+	if (cq.elements[i] && ++compsize[cq.elements[i]] > largest)
+	  largest = compsize[cq.elements[i]];
+      solv_free(compsize);
+      queue_free(&cq);
+      POOL_DEBUG(SOLV_DEBUG_STATS, "rules form %d independent components, the largest has %d packages\n", ncomp, largest);
+    }
 
   /* create weak map */
   map_init(&solv->weakrulemap, solv->nrules);
@@ -3072,7 +3438,9 @@ solver_solve(Solver *solv, Queue *job)
   POOL_DEBUG(SOLV_DEBUG_STATS, "final solver statistics: %d problems, %d learned rules, %d unsolvable\n", solv->problems.count / 2, solv->stats_learned, solv->stats_unsolvable);
   POOL_DEBUG(SOLV_DEBUG_STATS, "solver_solve took %d ms\n", solv_timems(solve_start));
 
-  /* return number of problems */
+  /* return number of problems, -1 if we ran out of budget */
+  if (solv->aborted)
+    return -1;
   return solv->problems.count ? solv->problems.count / 2 : 0;
 }
 
@@ -3484,14 +3852,51 @@ solver_describe_decision(Solver *solv, Id p, Id *infop)
 }
 
 
+static int
+whatrecommends_sortcmp(const void *ap, const void *bp, void *dp)
+{
+  return *(Id *)ap - *(Id *)bp;
+}
+
+/* collect the packages that may recommend s, sorted by id.
+ * The recommends are not checked, see pool_whatdeps_ptr() */
+static void
+solver_whatrecommends(Solver *solv, Solvable *s, Queue *q)
+{
+  Pool *pool = solv->pool;
+  Id *pp, prv, *prvp;
+
+  for (pp = pool_whatdeps_ptr(pool, SOLVABLE_RECOMMENDS, 0); *pp; pp++)
+    queue_push(q, *pp);
+  for (pp = pool_whatdeps_ptr(pool, SOLVABLE_RECOMMENDS, s->name); *pp; pp++)
+    queue_push(q, *pp);
+  if (s->provides)
+    {
+      prvp = s->repo->idarraydata + s->provides;
+      while ((prv = *prvp++) != 0)
+	for (pp = pool_whatdeps_ptr(pool, SOLVABLE_RECOMMENDS, prv); *pp; pp++)
+	  queue_push(q, *pp);
+    }
+  if (q->count > 1)
+    {
+      int i, j;
+      solv_sort(q->elements, q->count, sizeof(Id), whatrecommends_sortcmp, 0);
+      for (i = j = 1; i < q->count; i++)
+	if (q->elements[i] != q->elements[j - 1])
+	  q->elements[j++] = q->elements[i];
+      queue_truncate(q, j);
+    }
+}
+
 void
 solver_describe_weakdep_decision(Solver *solv, Id p, Queue *whyq)
 {
   Pool *pool = solv->pool;
-  int i;
+  int i, j;
   int level = solv->decisionmap[p];
   int decisionno;
   Solvable *s;
+  Queue recq;
 
   queue_empty(whyq);
   if (level < 0)
@@ -3505,9 +3910,13 @@ solver_describe_weakdep_decision(Solver *solv, Id p, Queue *whyq)
     return;	/* huh? */
 
   /* 1) list all packages that recommend us */
-  for (i = 1; i < pool->nsolvables; i++)
+  queue_init(&recq);
+  s = pool->solvables + p;
+  solver_whatrecommends(solv, s, &recq);
+  for (j = 0; j < recq.count; j++)
     {
       Id *recp, rec, pp2, p2;
+      i = recq.elements[j];
       if (solv->decisionmap[i] < 0 || solv->decisionmap[i] >= level)
 	continue;
       s = pool->solvables + i;
@@ -3537,6 +3946,7 @@ solver_describe_weakdep_decision(Solver *solv, Id p, Queue *whyq)
 	    }
 	}
     }
+  queue_free(&recq);
   /* 2) list all supplements */
   s = pool->solvables + p;
   if (s->supplements && level > 0)
@@ -176,6 +176,7 @@ struct _Solver {
 
   Id *obsoletes;			/* obsoletes for each installed solvable */
   Id *obsoletes_data;			/* data area for obsoletes */
+  int obsoletes_generation;		/* generation of the pool index we copied, 0 if our own */
   Id *multiversionupdaters;		/* updaters for multiversion packages in updatesystem mode */
 
   /*-------------------------------------------------------------------------------------------------------------
@@ -194,6 +195,7 @@ struct _Solver {
   int dontshowinstalledrecommended;	/* true: do not show recommended packages that are already installed */
   
   int noinfarchcheck;			/* true: do not forbid inferior architectures */
+  int activityheuristic;		/* true: branch by conflict activity and saved phase, restart */
 
     
   Map dupmap;				/* dup these packages*/
@@ -213,6 +215,24 @@ struct _Solver {
 
   Queue *cleandeps_updatepkgs;		/* packages we update in cleandeps mode */
   Queue *cleandeps_mistakes;		/* mistakes we made */
+  Queue *cleandeps_graph;		/* requires/recommends between installed packages */
+  Map cleandeps_pinned;			/* installed patterns/products, always userinstalled */
+
+  int budget_propagations;		/* abort after that many propagated decisions */
+  int budget_conflicts;			/* abort after that many conflicts */
+  int budget_time;			/* abort after that many ms */
+  int (*abortcallback)(struct _Solver *solv, void *data);
+  void *abortcallbackdata;
+  int budget_active;			/* true: one of the above is set */
+  unsigned int budget_start;		/* start time of the budgeted operation */
+  int budget_nextcheck;			/* do time/callback check at that propagation count */
+  int stats_propagations;		/* propagated decisions since budget start */
+  int stats_conflicts;			/* conflicts since budget start */
+  int aborted;				/* true: budget exhausted */
+
+  unsigned int *activity;		/* conflict activity of each solvable (activityheuristic) */
+  unsigned int activityinc;		/* current activity bump */
+  Map phasemap;				/* saved phase: was installed before we reverted */
 #endif	/* LIBSOLV_INTERNAL */
 };
 
@@ -283,6 +303,11 @@ typedef struct _Solver Solver;
 #define SOLVER_FLAG_ADD_ALREADY_RECOMMENDED	8
 #define SOLVER_FLAG_NO_INFARCHCHECK		9
 #define SOLVER_FLAG_ALLOW_NAMECHANGE		10
+#define SOLVER_FLAG_ACTIVITY_HEURISTIC		11
+
+#define SOLVER_BUDGET_PROPAGATIONS		1
+#define SOLVER_BUDGET_CONFLICTS			2
+#define SOLVER_BUDGET_TIME			3	/* in ms */
 
 extern Solver *solver_create(Pool *pool);
 extern void solver_free(Solver *solv);
@@ -290,6 +315,10 @@ extern int  solver_solve(Solver *solv, Queue *job);
 extern Transaction *solver_create_transaction(Solver *solv);
 extern int solver_set_flag(Solver *solv, int flag, int value);
 extern int solver_get_flag(Solver *solv, int flag);
+extern int solver_set_budget(Solver *solv, int budget, int value);
+extern int solver_get_budget(Solver *solv, int budget);
+extern void solver_set_abortcallback(Solver *solv, int (*cb)(Solver *solv, void *data), void *data);
+extern int solver_aborted(Solver *solv);
 
 extern int  solver_get_decisionlevel(Solver *solv, Id p);
 extern void solver_get_decisionqueue(Solver *solv, Queue *decisionq);
@@ -15,6 +15,9 @@
 
 extern void solver_run_sat(Solver *solv, int disablerules, int doweak);
 extern void solver_reset(Solver *solv);
+extern void solver_start_budget(Solver *solv);
+extern int solver_budget_exhausted(Solver *solv);
+extern void solver_freecleandepsgraph(Solver *solv);
 
 extern int solver_dep_installed(Solver *solv, Id dep);
 extern int solver_splitprovides(Solver *solv, Id dep);
@@ -677,11 +677,10 @@ transaction_create_decisionq(Pool *pool, Queue *decisionq, Map *noobsmap)
 
   if (installed)
     {
-      FOR_REPO_SOLVABLES(installed, p, s)
-	{
-	  if (MAPTST(&trans->transactsmap, p))
-	    queue_push(&trans->steps, p);
-	}
+      /* the transactsmap is sparse, just look at the set bits */
+      for (p = map_next(&trans->transactsmap, installed->start); p >= 0 && p < installed->end; p = map_next(&trans->transactsmap, p + 1))
+	if (pool->solvables[p].repo == installed)
+	  queue_push(&trans->steps, p);
     }
   for (i = 0; i < decisionq->count; i++)
     {
@@ -862,17 +861,78 @@ struct orderdata {
   Id *edgedata;
   int nedgedata;
   Id *invedgedata;
+  Id *p2te;		/* solvable id -> te number, 0 if not in the transaction */
+
+  Id *nteedges;		/* te -> number of edges */
+  Id *teedgespace;	/* te -> number of edges that fit into the edge list */
+
+  /* edge index, so that we do not need to scan the edge lists.
+   * edgeinfo[3 * e] is (from, to, offset in from's edge list) */
+  Id *edgeinfo;
+  int nedgeinfo;
+  Hashtable edgehashtbl;	/* (from, to) hash -> edge number */
+  Hashmask edgehashmask;
 
   Queue cycles;
   Queue cyclesdata;
   int ncycles;
 };
 
+#define EDGEINFO_BLOCK	255
+
+static inline Hashval
+edgehash(Id from, Id to)
+{
+  return (Hashval)from * 0x9e3779b1 + (Hashval)to * 0x85ebca6b;
+}
+
+static void
+edgehash_rehash(struct orderdata *od)
+{
+  Hashval h, hh;
+  Hashmask hashmask;
+  Id e;
+
+  hashmask = mkmask(od->nedgeinfo + EDGEINFO_BLOCK);
+  od->edgehashtbl = solv_free(od->edgehashtbl);
+  od->edgehashtbl = solv_calloc(hashmask + 1, sizeof(Id));
+  od->edgehashmask = hashmask;
+  for (e = 1; e < od->nedgeinfo; e++)
+    {
+      h = edgehash(od->edgeinfo[3 * e], od->edgeinfo[3 * e + 1]) & hashmask;
+      hh = HASHCHAIN_START;
+      while (od->edgehashtbl[h])
+	h = HASHCHAIN_NEXT(h, hh, hashmask);
+      od->edgehashtbl[h] = e;
+    }
+}
+
+/* returns the position of the from->to edge in edgedata, 0 if there is no such edge */
+static inline int
+findteedge(struct orderdata *od, int from, int to)
+{
+  Hashval h, hh;
+  Hashmask hashmask = od->edgehashmask;
+  Id e;
+
+  h = edgehash(from, to) & hashmask;
+  hh = HASHCHAIN_START;
+  while ((e = od->edgehashtbl[h]) != 0)
+    {
+      if (od->edgeinfo[3 * e] == from && od->edgeinfo[3 * e + 1] == to)
+	return od->tes[from].edges + od->edgeinfo[3 * e + 2];
+      h = HASHCHAIN_NEXT(h, hh, hashmask);
+    }
+  return 0;
+}
+
 static int
 addteedge(struct orderdata *od, int from, int to, int type)
 {
-  int i;
+  int i, n, space;
   struct _TransactionElement *te;
+  Hashval h, hh;
+  Id e;
 
   if (from == to)
     return 0;
@@ -880,37 +940,57 @@ addteedge(struct orderdata *od, int from, int to, int type)
   /* printf("edge %d(%s) -> %d(%s) type %x\n", from, pool_solvid2str(pool, od->tes[from].p), to, pool_solvid2str(pool, od->tes[to].p), type); */
 
   te = od->tes + from;
-  for (i = te->edges; od->edgedata[i]; i += 2)
-    if (od->edgedata[i] == to)
-      break;
+  i = findteedge(od, from, to);
   /* test of brokenness */
   if (type == TYPE_BROKEN)
-    return od->edgedata[i] && (od->edgedata[i + 1] & TYPE_BROKEN) != 0 ? 1 : 0;
-  if (od->edgedata[i])
+    return i && (od->edgedata[i + 1] & TYPE_BROKEN) != 0 ? 1 : 0;
+  if (i)
     {
       od->edgedata[i + 1] |= type;
       return 0;
     }
-  if (i + 1 == od->nedgedata)
+  n = od->nteedges[from];
+  if (n == od->teedgespace[from])
     {
-      /* printf("tail add %d\n", i - te->edges); */
-      if (!i)
-	te->edges = ++i;
-      od->edgedata = solv_extend(od->edgedata, od->nedgedata, 3, sizeof(Id), EDGEDATA_BLOCK);
-    }
-  else
-    {
-      /* printf("extend %d\n", i - te->edges); */
-      od->edgedata = solv_extend(od->edgedata, od->nedgedata, 3 + (i - te->edges), sizeof(Id), EDGEDATA_BLOCK);
-      if (i > te->edges)
-	memcpy(od->edgedata + od->nedgedata, od->edgedata + te->edges, sizeof(Id) * (i - te->edges));
-      i = od->nedgedata + (i - te->edges);
-      te->edges = od->nedgedata;
+      /* no room left, grow the edge list. Double the space so that
+       * we do not need to move big lists over and over again */
+      space = n < 2 ? 2 : 2 * n;
+      if (n && te->edges + 2 * n + 1 == od->nedgedata)
+	{
+	  /* printf("tail add %d\n", n); */
+	  od->edgedata = solv_extend(od->edgedata, od->nedgedata, 2 * (space - n), sizeof(Id), EDGEDATA_BLOCK);
+	  od->nedgedata += 2 * (space - n);
+	}
+      else
+	{
+	  /* printf("extend %d\n", n); */
+	  od->edgedata = solv_extend(od->edgedata, od->nedgedata, 2 * space + 1, sizeof(Id), EDGEDATA_BLOCK);
+	  if (n)
+	    memcpy(od->edgedata + od->nedgedata, od->edgedata + te->edges, sizeof(Id) * 2 * n);
+	  te->edges = od->nedgedata;
+	  od->nedgedata += 2 * space + 1;
+	}
+      od->teedgespace[from] = space;
     }
+  i = te->edges + 2 * n;
   od->edgedata[i] = to;
   od->edgedata[i + 1] = type;
   od->edgedata[i + 2] = 0;	/* end marker */
-  od->nedgedata = i + 3;
+
+  /* update the edge index */
+  if ((Hashval)od->nedgeinfo * 2 > od->edgehashmask)
+    edgehash_rehash(od);
+  e = od->nedgeinfo++;
+  od->edgeinfo = solv_extend(od->edgeinfo, e, 1, 3 * sizeof(Id), EDGEINFO_BLOCK);
+  od->edgeinfo[3 * e] = from;
+  od->edgeinfo[3 * e + 1] = to;
+  od->edgeinfo[3 * e + 2] = i - te->edges;
+  od->nteedges[from]++;
+  h = edgehash(from, to) & od->edgehashmask;
+  hh = HASHCHAIN_START;
+  while (od->edgehashtbl[h])
+    h = HASHCHAIN_NEXT(h, hh, od->edgehashmask);
+  od->edgehashtbl[h] = e;
   return 0;
 }
 
@@ -920,7 +1000,6 @@ addedge(struct orderdata *od, Id from, Id to, int type)
   Transaction *trans = od->trans;
   Pool *pool = trans->pool;
   Solvable *s;
-  struct _TransactionElement *te;
   int i;
 
   /* printf("addedge %d %d type %d\n", from, to, type); */
@@ -966,20 +1045,11 @@ addedge(struct orderdata *od, Id from, Id to, int type)
     }
 
   /* map from/to to te numbers */
-  for (i = 1, te = od->tes + i; i < od->ntes; i++, te++)
-    if (te->p == to)
-      break;
-  if (i == od->ntes)
+  if (!(to = od->p2te[to]))
     return 0;
-  to = i;
-
-  for (i = 1, te = od->tes + i; i < od->ntes; i++, te++)
-    if (te->p == from)
-      break;
-  if (i == od->ntes)
+  if (!(from = od->p2te[from]))
     return 0;
-
-  return addteedge(od, i, to, type);
+  return addteedge(od, from, to, type);
 }
 
 #if 1
@@ -1447,22 +1517,22 @@ addcycleedges(struct orderdata *od, Id *cycle, Queue *todo)
     te->mark = 0;
   for (i = 0; (j = cycle[i]) != 0; i++)
     {
-      od->tes[j].mark = -1;
+      od->tes[j].mark = 2;
       queue_push(todo, j);
     }
+  /* we only need the set of reachable TEs, so mark them when they
+   * get queued. This makes sure that every TE is queued once */
   while (todo->count)
     {
       i = queue_pop(todo);
       te = od->tes + i;
-      if (te->mark > 0)
-	continue;
-      te->mark = te->mark < 0 ? 2 : 1;
       for (j = te->edges; (k = od->edgedata[j]) != 0; j += 2)
 	{
 	  if ((od->edgedata[j + 1] & TYPE_BROKEN) != 0)
 	    continue;
-	  if (od->tes[k].mark > 0)
+	  if (od->tes[k].mark)
 	    continue;	/* no need to visit again */
+	  od->tes[k].mark = 1;
 	  queue_push(todo, k);
 	}
     }
@@ -1594,9 +1664,15 @@ transaction_order(Transaction *trans, int flags)
   od.edgedata = solv_extend(0, 0, 1, sizeof(Id), EDGEDATA_BLOCK);
   od.edgedata[0] = 0;
   od.nedgedata = 1;
+  od.edgeinfo = solv_extend(0, 0, 1, 3 * sizeof(Id), EDGEINFO_BLOCK);
+  od.nedgeinfo = 1;
+  edgehash_rehash(&od);
+  od.nteedges = solv_calloc(numte, sizeof(Id));
+  od.teedgespace = solv_calloc(numte, sizeof(Id));
   queue_init(&od.cycles);
 
   /* initialize TEs */
+  od.p2te = solv_calloc(pool->nsolvables, sizeof(Id));
   for (i = 0, te = od.tes + 1; i < tr->count; i++)
     {
       p = tr->elements[i];
@@ -1604,12 +1680,14 @@ transaction_order(Transaction *trans, int flags)
       if (installed && s->repo == installed && trans->transaction_installed[p - installed->start])
 	continue;
       te->p = p;
+      od.p2te[p] = te - od.tes;
       te++;
     }
 
   /* create dependency graph */
   for (i = 0; i < tr->count; i++)
     addsolvableedges(&od, pool->solvables + tr->elements[i]);
+  od.p2te = solv_free(od.p2te);
 
   /* count edges */
   numedge = 0;
@@ -1689,10 +1767,8 @@ transaction_order(Transaction *trans, int flags)
 	  assert(te->mark == 1);
 	  te->mark = 0;	/* reset investigation marker */
 	  /* printf("searching for edge from %d to %d\n", cycle[k - 1], cycle[k]); */
-	  for (j = te->edges; od.edgedata[j]; j += 2)
-	    if (od.edgedata[j] == cycle[k])
-	      break;
-	  assert(od.edgedata[j]);
+	  j = findteedge(&od, cycle[k - 1], cycle[k]);
+	  assert(j);
 	  cycle[k * 2 - 1] = j;
 	}
       /* now cycle looks like this: */
@@ -1718,6 +1794,10 @@ transaction_order(Transaction *trans, int flags)
          addcycleedges(&od, od.cyclesdata.elements + od.cycles.elements[i], &todo);
      }
   POOL_DEBUG(SOLV_DEBUG_STATS, "cycle edge creation took %d ms\n", solv_timems(now));
+  od.edgeinfo = solv_free(od.edgeinfo);
+  od.edgehashtbl = solv_free(od.edgehashtbl);
+  od.nteedges = solv_free(od.nteedges);
+  od.teedgespace = solv_free(od.teedgespace);
 
 #if 0
   dump_tes(&od);
@@ -1940,7 +2020,6 @@ transaction_add_obsoleted(Transaction *trans)
   Pool *pool = trans->pool;
   Repo *installed = pool->installed;
   Id p;
-  Solvable *s;
   int i, j, k, max;
   Map done;
   Queue obsq, *steps;
@@ -1949,8 +2028,8 @@ transaction_add_obsoleted(Transaction *trans)
     return;
   /* calculate upper bound */
   max = 0;
-  FOR_REPO_SOLVABLES(installed, p, s)
-    if (MAPTST(&trans->transactsmap, p))
+  for (p = map_next(&trans->transactsmap, installed->start); p >= 0 && p < installed->end; p = map_next(&trans->transactsmap, p + 1))
+    if (pool->solvables[p].repo == installed)
       max++;
   if (!max)
     return;
@@ -1991,7 +2070,7 @@ transaction_add_obsoleted(Transaction *trans)
 }
 
 static void
-transaction_check_pkg(Transaction *trans, Id tepkg, Id pkg, Map *ins, Map *seen, int onlyprereq, Id noconfpkg, int depth)
+transaction_check_pkg(Transaction *trans, Id tepkg, Id pkg, Map *ins, Map *seen, Queue *seenq, int onlyprereq, Id noconfpkg, int depth)
 {
   Pool *pool = trans->pool;
   Id p, pp;
@@ -2001,6 +2080,7 @@ transaction_check_pkg(Transaction *trans, Id tepkg, Id pkg, Map *ins, Map *seen,
   if (MAPTST(seen, pkg))
     return;
   MAPSET(seen, pkg);
+  queue_push(seenq, pkg);
   s = pool->solvables + pkg;
 #if 0
   printf("- %*s%c%s\n", depth * 2, "", s->repo == pool->installed ? '-' : '+', pool_solvable2str(pool, s));
@@ -2030,7 +2110,7 @@ transaction_check_pkg(Transaction *trans, Id tepkg, Id pkg, Map *ins, Map *seen,
 	      if (MAPTST(&trans->transactsmap, p))
 		continue;
 	      good++;
-	      transaction_check_pkg(trans, tepkg, p, ins, seen, 0, noconfpkg, depth + 1);
+	      transaction_check_pkg(trans, tepkg, p, ins, seen, seenq, 0, noconfpkg, depth + 1);
 	    }
 	  if (!good)
 	    {
@@ -2041,7 +2121,7 @@ transaction_check_pkg(Transaction *trans, Id tepkg, Id pkg, Map *ins, Map *seen,
 		  if (pool->solvables[p].repo == pool->installed)
 		    continue;
 		  good++;
-		  transaction_check_pkg(trans, tepkg, p, ins, seen, 0, noconfpkg, depth + 1);
+		  transaction_check_pkg(trans, tepkg, p, ins, seen, seenq, 0, noconfpkg, depth + 1);
 		}
 	    }
 	  if (!good)
@@ -2051,7 +2131,7 @@ transaction_check_pkg(Transaction *trans, Id tepkg, Id pkg, Map *ins, Map *seen,
 		  if (!MAPTST(ins, p))
 		    continue;
 		  good++;
-		  transaction_check_pkg(trans, tepkg, p, ins, seen, 0, noconfpkg, depth + 1);
+		  transaction_check_pkg(trans, tepkg, p, ins, seen, seenq, 0, noconfpkg, depth + 1);
 		}
 	    }
 	  if (!good)
@@ -2069,11 +2149,13 @@ transaction_check_order(Transaction *trans)
   Solvable *s;
   Id p, lastins;
   Map ins, seen;
-  int i;
+  Queue seenq;
+  int i, j;
 
   POOL_DEBUG(SOLV_WARN, "\nchecking transaction order...\n");
   map_init(&ins, pool->nsolvables);
   map_init(&seen, pool->nsolvables);
+  queue_init(&seenq);
   if (pool->installed)
     FOR_REPO_SOLVABLES(pool->installed, p, s)
       MAPSET(&ins, p);
@@ -2088,12 +2170,16 @@ transaction_check_order(Transaction *trans)
 	MAPSET(&ins, p);
       if (havescripts(pool, p))
 	{
-	  MAPZERO(&seen);
-	  transaction_check_pkg(trans, p, p, &ins, &seen, 1, lastins, 0);
+	  transaction_check_pkg(trans, p, p, &ins, &seen, &seenq, 1, lastins, 0);
+	  /* reset just the entries we visited, much cheaper than zeroing the map */
+	  for (j = 0; j < seenq.count; j++)
+	    MAPCLR(&seen, seenq.elements[j]);
+	  queue_empty(&seenq);
 	}
       if (s->repo == pool->installed)
 	MAPCLR(&ins, p);
     }
+  queue_free(&seenq);
   map_free(&seen);
   map_free(&ins);
   POOL_DEBUG(SOLV_WARN, "transaction order check done.\n");
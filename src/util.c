@@ -76,6 +76,18 @@ solv_calloc(size_t num, size_t len)
   return r;
 }
 
+void *
+solv_memdup2(const void *mem, size_t num, size_t len)
+{
+  void *r;
+  if (!mem)
+    return 0;
+  r = solv_malloc2(num, len);
+  if (num && len)
+    memcpy(r, mem, num * len);
+  return r;
+}
+
 void *
 solv_free(void *mem)
 {
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * bitmap.c
+ *
+ * check the map operations against a bit by bit implementation,
+ * for sizes that are not a multiple of the word size and for
+ * maps that are not word aligned
+ */
+
+#include <string.h>
+
+#include "bitmap.h"
+#include "util.h"
+#include "testutil.h"
+
+/* map sizes in bytes */
+static int sizes[] = { 0, 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129, 200, 1000 };
+#define NSIZES	(int)(sizeof(sizes) / sizeof(*sizes))
+
+static unsigned int seed = 42;
+
+/* a map of nbytes bytes with random bits that starts at offset off
+ * of a buffer, so that it is not word aligned for off != 0 */
+static void
+randommap(Map *m, unsigned char *buf, int off, int nbytes, int density)
+{
+  int i;
+  m->map = buf + off;
+  m->size = nbytes;
+  for (i = 0; i < nbytes * 8; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      if ((int)((seed >> 16) % 8) < density)
+	MAPSET(m, i);
+      else
+	MAPCLR(m, i);
+    }
+}
+
+static int
+tst(Map *m, int n)
+{
+  return n < m->size * 8 && MAPTST(m, n);
+}
+
+static void
+checkops(Map *t, Map *s, int off)
+{
+  Map r, c;
+  unsigned char *rbuf;
+  int i, n, nbits, cnt;
+
+  /* map_or grows t if needed, so work on a malloced copy */
+  n = t->size > s->size ? t->size : s->size;
+  map_init(&c, t->size * 8);
+  memcpy(c.map, t->map, t->size);
+  map_or(&c, s);
+  check(c.size == n);
+  for (i = 0; i < n * 8; i++)
+    check(!!tst(&c, i) == (tst(t, i) || tst(s, i)));
+  map_free(&c);
+
+  /* map_subtract, t keeps its size */
+  rbuf = solv_calloc(t->size + off + 1, 1);
+  r.map = rbuf + off;
+  r.size = t->size;
+  memcpy(r.map, t->map, t->size);
+  map_subtract(&r, s);
+  for (i = 0; i < t->size * 8; i++)
+    check(!!tst(&r, i) == (tst(t, i) && !tst(s, i)));
+
+  /* map_and, s must not be smaller than t */
+  if (s->size >= t->size)
+    {
+      memcpy(r.map, t->map, t->size);
+      map_and(&r, s);
+      for (i = 0; i < t->size * 8; i++)
+	check(!!tst(&r, i) == (tst(t, i) && tst(s, i)));
+    }
+  solv_free(rbuf);
+
+  /* map_count and map_next */
+  nbits = t->size * 8;
+  for (i = cnt = 0; i < nbits; i++)
+    if (tst(t, i))
+      cnt++;
+  check(map_count(t) == cnt);
+  n = -1;
+  for (i = nbits - 1; i >= 0; i--)
+    {
+      if (tst(t, i))
+	n = i;
+      check(map_next(t, i) == n);
+    }
+  check(map_next(t, -5) == n);
+  check(map_next(t, nbits) == -1);
+  check(map_next(t, nbits + 100) == -1);
+  for (i = 0, n = map_next(t, 0); n >= 0; n = map_next(t, n + 1))
+    i++;
+  check(i == cnt);
+}
+
+int
+main(void)
+{
+  unsigned char *tbuf, *sbuf;
+  Map t, s;
+  int i, j, off, density;
+
+  tbuf = solv_calloc(1000 + 8, 1);
+  sbuf = solv_calloc(1000 + 8, 1);
+  for (off = 0; off < 4; off += 3)
+    for (density = 0; density <= 8; density++)
+      for (i = 0; i < NSIZES; i++)
+	for (j = 0; j < NSIZES; j++)
+	  {
+	    randommap(&t, tbuf, off, sizes[i], density);
+	    randommap(&s, sbuf, 3 - off, sizes[j], 8 - density);
+	    checkops(&t, &s, off);
+	  }
+  /* a single bit at every position */
+  for (i = 0; i < 129 * 8; i++)
+    {
+      map_init(&t, 129 * 8);
+      MAPSET(&t, i);
+      check(map_count(&t) == 1);
+      check(map_next(&t, 0) == i);
+      check(map_next(&t, i) == i);
+      check(map_next(&t, i + 1) == -1);
+      map_free(&t);
+    }
+  solv_free(tbuf);
+  solv_free(sbuf);
+  return 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * budget.c
+ *
+ * check that a solver that ran out of budget can be used again and
+ * then gives the same result as a fresh solver
+ */
+
+#include <string.h>
+
+#include "pool.h"
+#include "poolarch.h"
+#include "repo.h"
+#include "solver.h"
+#include "util.h"
+#include "testutil.h"
+
+static const char *testrepo =
+  /* a and b conflict, both requires chains need some propagations */
+  "=Pkg: a 1 1 noarch\n"
+  "=Req: c0\n"
+  "=Con: b\n"
+  "=Pkg: b 1 1 noarch\n"
+  "=Req: d0\n"
+  "=Pkg: c0 1 1 noarch\n=Req: c1\n"
+  "=Pkg: c1 1 1 noarch\n=Req: c2\n"
+  "=Pkg: c2 1 1 noarch\n=Req: c3\n"
+  "=Pkg: c3 1 1 noarch\n"
+  "=Pkg: d0 1 1 noarch\n=Req: d1\n"
+  "=Pkg: d1 1 1 noarch\n=Req: d2\n"
+  "=Pkg: d2 1 1 noarch\n"
+  /* the solver first picks x-2, which leads to a conflict */
+  "=Pkg: e 1 1 noarch\n"
+  "=Req: X\n"
+  "=Pkg: x 2 1 noarch\n"
+  "=Prv: X\n"
+  "=Req: y\n"
+  "=Req: z\n"
+  "=Pkg: x 1 1 noarch\n"
+  "=Prv: X\n"
+  "=Pkg: y 1 1 noarch\n"
+  "=Con: z\n"
+  "=Pkg: z 1 1 noarch\n";
+
+static Id
+findsolvable(Pool *pool, const char *str)
+{
+  Id p;
+  for (p = 2; p < pool->nsolvables; p++)
+    if (!strcmp(pool_solvid2str(pool, p), str))
+      return p;
+  check(0);
+  return 0;
+}
+
+/* the decisions, problems and solutions of a solver run */
+static void
+result(Solver *solv, Queue *q)
+{
+  Id problem, solution, element, p, rp;
+
+  queue_empty(q);
+  solver_get_decisionqueue(solv, q);
+  queue_push(q, 0);
+  queue_push(q, solver_problem_count(solv));
+  for (problem = 1; problem <= solver_problem_count(solv); problem++)
+    {
+      queue_push(q, solver_solution_count(solv, problem));
+      check(!solver_aborted(solv));
+      for (solution = 1; solution <= solver_solution_count(solv, problem); solution++)
+	{
+	  queue_push(q, solver_solutionelement_count(solv, problem, solution));
+	  element = 0;
+	  while ((element = solver_next_solutionelement(solv, problem, solution, element, &p, &rp)) != 0)
+	    queue_push2(q, p, rp);
+	}
+    }
+}
+
+static void
+checksame(Queue *q1, Queue *q2)
+{
+  int i;
+  check(q1->count == q2->count);
+  for (i = 0; i < q1->count; i++)
+    check(q1->elements[i] == q2->elements[i]);
+}
+
+static int
+abortcb(Solver *solv, void *data)
+{
+  int *ncalls = data;
+  return ++*ncalls >= 2;
+}
+
+/* the propagations at the time the first conflict was analyzed */
+static int conflictpropagations;
+
+static void
+analyzecb(Pool *pool, void *data, int type, const char *str)
+{
+  Solver *solv = *(Solver **)data;
+  if (solv && !strncmp(str, "reverting decisions", 19) && solv->stats_conflicts == 1)
+    conflictpropagations = solv->stats_propagations;
+}
+
+static void
+checkjob(Pool *pool, Queue *job, int nproblems)
+{
+  Solver *solv;
+  Queue ref, q, dq;
+  int r, ncalls;
+
+  queue_init(&ref);
+  queue_init(&q);
+  queue_init(&dq);
+
+  /* reference result from a fresh solver */
+  solv = solver_create(pool);
+  check(solver_solve(solv, job) == nproblems);
+  check(!solver_aborted(solv));
+  result(solv, &ref);
+  solver_free(solv);
+
+  /* solving twice with the same solver gives the same result */
+  solv = solver_create(pool);
+  check(solver_solve(solv, job) == nproblems);
+  check(solver_solve(solv, job) == nproblems);
+  result(solv, &q);
+  checksame(&ref, &q);
+  solver_free(solv);
+
+  /* abort, then solve again with the same solver */
+  solv = solver_create(pool);
+  check(solver_set_budget(solv, SOLVER_BUDGET_PROPAGATIONS, 1) == 0);
+  check(solver_get_budget(solv, SOLVER_BUDGET_PROPAGATIONS) == 1);
+  check(solver_solve(solv, job) == -1);
+  check(solver_aborted(solv));
+  check(solver_set_budget(solv, SOLVER_BUDGET_PROPAGATIONS, 0) == 1);
+  check(solver_solve(solv, job) == nproblems);
+  check(!solver_aborted(solv));
+  result(solv, &q);
+  checksame(&ref, &q);
+  solver_free(solv);
+
+  /* the abort callback */
+  solv = solver_create(pool);
+  ncalls = 0;
+  solver_set_abortcallback(solv, abortcb, &ncalls);
+  r = solver_solve(solv, job);
+  check(r == -1 ? solver_aborted(solv) && ncalls == 2 : r == nproblems && ncalls < 2);
+  solver_set_abortcallback(solv, 0, 0);
+  check(solver_solve(solv, job) == nproblems);
+  result(solv, &q);
+  checksame(&ref, &q);
+  solver_free(solv);
+
+  if (!nproblems)
+    {
+      queue_free(&ref);
+      queue_free(&q);
+      queue_free(&dq);
+      return;
+    }
+
+  /* abort the solution creation, the problem must stay unrefined
+   * and the decisions must be restored */
+  solv = solver_create(pool);
+  check(solver_solve(solv, job) == nproblems);
+  solver_get_decisionqueue(solv, &dq);
+  solver_set_budget(solv, SOLVER_BUDGET_PROPAGATIONS, 1);
+  check(solver_solution_count(solv, 1) == 0);
+  check(solver_aborted(solv));
+  check(solver_next_solution(solv, 1, 0) == 0);
+  solver_get_decisionqueue(solv, &q);
+  checksame(&dq, &q);
+  check(solver_problem_count(solv) == nproblems);
+  solver_set_budget(solv, SOLVER_BUDGET_PROPAGATIONS, 0);
+  result(solv, &q);
+  checksame(&ref, &q);
+  solver_free(solv);
+
+  queue_free(&ref);
+  queue_free(&q);
+  queue_free(&dq);
+}
+
+int
+main(void)
+{
+  Pool *pool = pool_create();
+  Solver *solv = 0;
+  Queue job;
+
+  pool_setarch(pool, "x86_64");
+  testutil_addrepo(pool, "test", testrepo, 0);
+  pool_addfileprovides(pool);
+  pool_createwhatprovides(pool);
+  queue_init(&job);
+
+  /* unsolvable: a conflicts with b */
+  queue_push2(&job, SOLVER_INSTALL | SOLVER_SOLVABLE, findsolvable(pool, "a-1-1.noarch"));
+  queue_push2(&job, SOLVER_INSTALL | SOLVER_SOLVABLE, findsolvable(pool, "b-1-1.noarch"));
+  checkjob(pool, &job, 1);
+
+  /* solvable, but needs a conflict to get there */
+  queue_empty(&job);
+  queue_push2(&job, SOLVER_INSTALL | SOLVER_SOLVABLE_NAME, pool_str2id(pool, "e", 0));
+  checkjob(pool, &job, 0);
+  solv = solver_create(pool);
+  check(solver_solve(solv, &job) == 0);
+  check(solv->stats_conflicts > 0);
+  solver_free(solv);
+  /* the solver must stop right after the conflict, without
+   * propagating the learnt rule first */
+  solv = solver_create(pool);
+  solver_set_budget(solv, SOLVER_BUDGET_CONFLICTS, 1);
+  conflictpropagations = -1;
+  pool_setdebugcallback(pool, analyzecb, &solv);
+  pool_setdebugmask(pool, SOLV_DEBUG_ANALYZE);
+  check(solver_solve(solv, &job) == -1);
+  pool_setdebugmask(pool, 0);
+  pool_setdebugcallback(pool, 0, 0);
+  check(solver_aborted(solv));
+  check(solv->stats_conflicts == 1);
+  check(solv->stats_propagations == conflictpropagations);
+  solver_set_budget(solv, SOLVER_BUDGET_CONFLICTS, 0);
+  check(solver_solve(solv, &job) == 0);
+  check(!solver_aborted(solv));
+  solver_free(solv);
+
+  queue_free(&job);
+  pool_free(pool);
+  return 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * filelistindex.c
+ *
+ * check that file searches and pool_addfileprovides find the same
+ * solvables with and without the file list index, and that index
+ * lookups do not create directories
+ */
+
+#include <string.h>
+
+#include "pool.h"
+#include "repo.h"
+#include "repodata.h"
+#include "util.h"
+#include "testutil.h"
+
+#define NPKGS	200
+#define NFILES	30
+
+static const char *dirs[] = { "", "/usr/bin", "/usr/lib", "/usr/lib/foo", "/etc", "/opt/a/b" };
+#define NDIRS	(int)(sizeof(dirs) / sizeof(*dirs))
+
+static char has[NPKGS][NDIRS][NFILES];
+
+static void
+search(Pool *pool, Repo *repo, const char *file, Queue *q)
+{
+  Dataiterator di;
+
+  queue_empty(q);
+  dataiterator_init(&di, pool, repo, 0, SOLVABLE_FILELIST, file, SEARCH_STRING | SEARCH_FILES);
+  while (dataiterator_step(&di))
+    {
+      queue_push(q, di.solvid);
+      dataiterator_skip_solvable(&di);
+    }
+  dataiterator_free(&di);
+}
+
+static void
+checkfile(Pool *pool, Repo *repo, Repodata *data, const char *file, int d, int f)
+{
+  Queue q1, q2;
+  int i, n;
+
+  queue_init(&q1);
+  queue_init(&q2);
+  repodata_free_filelistindex(data);
+  search(pool, repo, file, &q1);
+  repodata_create_filelistindex(data);
+  check(data->filelistindex != 0);
+  search(pool, repo, file, &q2);
+  check(q1.count == q2.count);
+  for (i = 0; i < q1.count; i++)
+    check(q1.elements[i] == q2.elements[i]);
+  for (i = n = 0; i < NPKGS; i++)
+    if (d >= 0 && has[i][d][f])
+      {
+	check(n < q1.count && q1.elements[n] == repo->start + i);
+	n++;
+      }
+  check(n == q1.count);
+  queue_free(&q1);
+  queue_free(&q2);
+}
+
+/* the file provides added with the index must match the file lists */
+static void
+checkaddfileprovides(const char *repostr)
+{
+  Pool *pool = pool_create();
+  Repo *repo;
+  Repodata *data;
+  char *str = 0, buf[64];
+  Id p, pp, id;
+  int i, d, f, n;
+
+  repo = testutil_addrepo(pool, "test", repostr, 0);
+  data = repo_last_repodata(repo);
+  repodata_create_filelistindex(data);
+  check(data->filelistindex != 0);
+  /* skip dirs[0], addfileprovides does not find files in the root dir
+   * of susetags file lists, with or without the index */
+  for (d = 1; d < NDIRS; d++)
+    for (f = 0; f < NFILES; f += 3)
+      {
+	sprintf(buf, "=Pkg: dep%d-%d 1 1 noarch\n=Req: %s/f%d\n", d, f, dirs[d], f);
+	str = solv_dupappend(str, buf, 0);
+      }
+  str = solv_dupappend(str, "=Pkg: nodir 1 1 noarch\n=Req: /no/such/dir/f1\n", 0);
+  testutil_addrepo(pool, "deps", str, 0);
+  solv_free(str);
+  pool_addfileprovides(pool);
+  pool_createwhatprovides(pool);
+  check(data->filelistindex != 0);
+  check(data->dirpool.dirhashtbl == 0 && data->dirpool.dirparents == 0);
+
+  for (d = 1; d < NDIRS; d++)
+    for (f = 0; f < NFILES; f += 3)
+      {
+	sprintf(buf, "%s/f%d", dirs[d], f);
+	id = pool_str2id(pool, buf, 0);
+	check(id != 0);
+	n = 0;
+	FOR_PROVIDES(p, pp, id)
+	  {
+	    check(pool->solvables[p].repo == repo);
+	    check(has[p - repo->start][d][f]);
+	    n++;
+	  }
+	for (i = 0; i < NPKGS; i++)
+	  if (has[i][d][f])
+	    n--;
+	check(n == 0);
+      }
+  id = pool_str2id(pool, "/no/such/dir/f1", 0);
+  check(id != 0 && !*pool_whatprovides_ptr(pool, id));
+  pool_free(pool);
+}
+
+int
+main(void)
+{
+  Pool *pool = pool_create();
+  Repo *repo;
+  Repodata *data;
+  Id *solvids;
+  char *str = 0, buf[64];
+  unsigned int seed = 42;
+  int i, j, d, f, ndirs;
+
+  for (i = 0; i < NPKGS; i++)
+    {
+      /* the summary makes sure that the repodata does not look like
+       * a filtered file list extension */
+      sprintf(buf, "=Pkg: p%d 1 1 noarch\n=Sum: package %d\n", i, i);
+      str = solv_dupappend(str, buf, 0);
+      for (j = 0; j < 10; j++)
+	{
+	  seed = seed * 1103515245 + 12345;
+	  d = (seed >> 8) % NDIRS;
+	  f = (seed >> 16) % NFILES;
+	  if (has[i][d][f])
+	    continue;
+	  has[i][d][f] = 1;
+	  sprintf(buf, "=Prv: %s/f%d\n", dirs[d], f);
+	  str = solv_dupappend(str, buf, 0);
+	}
+    }
+  repo = testutil_addrepo(pool, "test", str, 0);
+  checkaddfileprovides(str);
+  solv_free(str);
+  check(repo->nsolvables == NPKGS);
+  data = repo_last_repodata(repo);
+  check(repodata_has_keyname(data, SOLVABLE_FILELIST));
+
+  for (d = 0; d < NDIRS; d++)
+    for (f = 0; f < NFILES; f++)
+      {
+	sprintf(buf, "%s/f%d", dirs[d], f);
+	checkfile(pool, repo, data, buf, d, f);
+      }
+  /* files and directories that are not there */
+  checkfile(pool, repo, data, "/usr/bin/f99", -1, 0);
+  checkfile(pool, repo, data, "/usr/f1", -1, 0);
+  checkfile(pool, repo, data, "/no/such/dir/f1", -1, 0);
+  checkfile(pool, repo, data, "f1", -1, 0);
+
+  /* lookups must not touch the directory data */
+  repodata_create_filelistindex(data);
+  ndirs = data->dirpool.ndirs;
+  check(repodata_filelistindex_lookup(data, "/no/such/dir/f1", &solvids) == 0);
+  check(repodata_filelistindex_lookup(data, "/usr/lib/nodir/f1", &solvids) == 0);
+  check(repodata_filelistindex_lookup(data, "/usr/lib/foo/f1", &solvids) >= 0);
+  check(data->dirpool.ndirs == ndirs);
+  check(data->dircache == 0);
+  check(data->dirpool.dirhashtbl == 0);
+
+  /* so must read-only dir lookups, they still find the dirs */
+  d = repodata_str2dir(data, "/usr/lib/foo", 0);
+  check(d != 0 && !strcmp(repodata_dir2str(data, d, 0), "/usr/lib/foo"));
+  check(repodata_str2dir(data, "/usr/lib/nodir", 0) == 0);
+  check(data->dirpool.ndirs == ndirs);
+  check(data->dirpool.dirhashtbl == 0 && data->dirpool.dirparents == 0);
+
+  pool_free(pool);
+  return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * keycolumn.c
+ *
+ * check that lookups return the same results with and without
+ * key columns
+ */
+
+#include <string.h>
+
+#include "pool.h"
+#include "repo.h"
+#include "repodata.h"
+#include "util.h"
+#include "testutil.h"
+
+#define NPKGS	100
+
+static Id keynames[] = { SOLVABLE_BUILDTIME, SOLVABLE_INSTALLSIZE, SOLVABLE_GROUP, SOLVABLE_LICENSE, SOLVABLE_INSTALLTIME, SOLVABLE_SUMMARY };
+#define NKEYNAMES	(int)(sizeof(keynames) / sizeof(*keynames))
+
+struct lookup {
+  Id type;
+  Id id;
+  int hasnum;
+  unsigned int num;
+};
+
+static void
+lookup(Repodata *data, Id p, Id keyname, struct lookup *l)
+{
+  l->type = repodata_lookup_type(data, p, keyname);
+  l->id = repodata_lookup_id(data, p, keyname);
+  l->hasnum = repodata_lookup_num(data, p, keyname, &l->num);
+}
+
+int
+main(void)
+{
+  Pool *pool = pool_create();
+  Repo *repo;
+  Repodata *data;
+  struct lookup *before, now;
+  char *str = 0, buf[64];
+  unsigned int seed = 42;
+  Id p, groups[3];
+  int i, k;
+
+  for (i = 0; i < NPKGS; i++)
+    {
+      sprintf(buf, "=Pkg: p%d 1 1 noarch\n=Sum: package %d\n", i, i);
+      str = solv_dupappend(str, buf, 0);
+    }
+  repo = testutil_addrepo(pool, "test", str, REPO_NO_INTERNALIZE);
+  solv_free(str);
+  check(repo->nsolvables == NPKGS);
+  data = repo_last_repodata(repo);
+  groups[0] = pool_str2id(pool, "System", 1);
+  groups[1] = pool_str2id(pool, "Development", 1);
+  groups[2] = pool_str2id(pool, "Games", 1);
+  /* give every key a mix of types, some solvables do not get the key */
+  for (p = repo->start; p < repo->end; p++)
+    {
+      seed = seed * 1103515245 + 12345;
+      switch ((seed >> 16) % 4)
+	{
+	case 0:
+	  repodata_set_num(data, p, SOLVABLE_BUILDTIME, seed);
+	  break;
+	case 1:
+	  repodata_set_num(data, p, SOLVABLE_BUILDTIME, 0x80000000 + p);
+	  break;
+	case 2:
+	  repodata_set_constant(data, p, SOLVABLE_BUILDTIME, 1234);
+	  break;
+	}
+      if (p % 3 != 0)
+	repodata_set_num(data, p, SOLVABLE_INSTALLSIZE, p * 7);
+      switch ((seed >> 20) % 3)
+	{
+	case 0:
+	  repodata_set_id(data, p, SOLVABLE_GROUP, groups[p % 3]);
+	  break;
+	case 1:
+	  repodata_set_constantid(data, p, SOLVABLE_GROUP, groups[2]);
+	  break;
+	}
+      if (p % 2)
+	repodata_set_id(data, p, SOLVABLE_LICENSE, groups[0]);
+      if (p % 5 == 0)
+	repodata_set_void(data, p, SOLVABLE_INSTALLTIME);
+    }
+  repodata_internalize(data);
+
+  before = solv_calloc(NKEYNAMES * (NPKGS + 2), sizeof(*before));
+  for (k = 0; k < NKEYNAMES; k++)
+    for (p = repo->start - 1; p <= repo->end; p++)
+      lookup(data, p, keynames[k], before + k * (NPKGS + 2) + (p - repo->start + 1));
+  for (k = 0; k < NKEYNAMES; k++)
+    repodata_create_keycolumn(data, keynames[k]);
+  check(data->keycolumns != 0);
+  for (k = 0; k < NKEYNAMES; k++)
+    for (p = repo->start - 1; p <= repo->end; p++)
+      {
+	struct lookup *l = before + k * (NPKGS + 2) + (p - repo->start + 1);
+	lookup(data, p, keynames[k], &now);
+	check(now.type == l->type);
+	check(now.id == l->id);
+	check(now.hasnum == l->hasnum);
+	check(now.num == l->num);
+      }
+  /* the columns are dropped if the data changes */
+  repodata_set_num(data, repo->start, SOLVABLE_BUILDTIME, 1);
+  repodata_internalize(data);
+  check(data->keycolumns == 0);
+
+  solv_free(before);
+  pool_free(pool);
+  return 0;
+}
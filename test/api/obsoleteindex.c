@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * obsoleteindex.c
+ *
+ * check that a solver uses an obsoletes index for its own installed
+ * repo, even if the pool has a different one, and that the cached
+ * update candidates follow pool->considered
+ */
+
+#include <string.h>
+
+#include "pool.h"
+#include "poolarch.h"
+#include "repo.h"
+#include "solver.h"
+#include "policy.h"
+#include "util.h"
+#include "testutil.h"
+
+static const char *systemrepo =
+  "=Pkg: oa 1 1 noarch\n"
+  "=Pkg: ob 1 1 noarch\n"
+  "=Pkg: oc 1 1 noarch\n"
+  "=Pkg: od 1 1 noarch\n"
+  "=Pkg: oe 1 1 noarch\n";
+
+static const char *otherrepo =
+  "=Pkg: x 1 1 noarch\n";
+
+static const char *availablerepo =
+  "=Pkg: n 1 1 noarch\n"
+  "=Obs: oa\n"
+  "=Obs: oe\n"
+  "=Pkg: x 2 1 noarch\n";
+
+/* check if the solver decided to install the named package */
+static int
+installs(Solver *solv, const char *str)
+{
+  Pool *pool = solv->pool;
+  int i;
+
+  for (i = 0; i < solv->decisionq.count; i++)
+    {
+      Id p = solv->decisionq.elements[i];
+      if (p > 0 && !strcmp(pool_solvid2str(pool, p), str))
+	return 1;
+    }
+  return 0;
+}
+
+static Id
+findsolvable(Pool *pool, const char *str)
+{
+  Id p;
+  for (p = 2; p < pool->nsolvables; p++)
+    if (!strcmp(pool_solvid2str(pool, p), str))
+      return p;
+  check(0);
+  return 0;
+}
+
+static void
+checkupdate(Solver *solv)
+{
+  Queue job;
+
+  queue_init(&job);
+  queue_push2(&job, SOLVER_UPDATE | SOLVER_SOLVABLE_ALL, 0);
+  check(solver_solve(solv, &job) == 0);
+  check(installs(solv, "n-1-1.noarch"));
+  check(!installs(solv, "oa-1-1.noarch"));
+  check(!installs(solv, "oe-1-1.noarch"));
+  check(installs(solv, "ob-1-1.noarch"));
+  queue_free(&job);
+}
+
+int
+main(void)
+{
+  Pool *pool = pool_create();
+  Repo *system, *other;
+  Solver *solv;
+  Map considered;
+  Queue q;
+  Id oa, n;
+
+  pool_setarch(pool, "x86_64");
+  system = testutil_addrepo(pool, "system", systemrepo, 0);
+  other = testutil_addrepo(pool, "other", otherrepo, 0);
+  testutil_addrepo(pool, "available", availablerepo, 0);
+
+  /* the pool index */
+  pool_set_installed(pool, system);
+  pool_createwhatprovides(pool);
+  solv = solver_create(pool);
+  checkupdate(solv);
+  check(pool->obsoletes != 0);
+  solver_free(solv);
+
+  /* the pool switched to a smaller installed repo after the solver
+   * was created */
+  solv = solver_create(pool);
+  pool_set_installed(pool, other);
+  pool_createwhatprovides(pool);
+  checkupdate(solv);
+  check(solv->installed == system);
+  solver_free(solv);
+
+  /* the update candidates must not come from a cache made with a
+   * different considered map */
+  pool_set_installed(pool, system);
+  pool_createwhatprovides(pool);
+  oa = findsolvable(pool, "oa-1-1.noarch");
+  n = findsolvable(pool, "n-1-1.noarch");
+  queue_init(&q);
+  solv = solver_create(pool);
+  checkupdate(solv);
+  policy_findupdatepackages(solv, pool->solvables + oa, &q, 0);
+  check(q.count == 1 && q.elements[0] == n);
+  solver_free(solv);
+  map_init(&considered, pool->nsolvables);
+  map_setall(&considered);
+  MAPCLR(&considered, n);
+  pool->considered = &considered;
+  solv = solver_create(pool);
+  queue_empty(&q);
+  check(solver_solve(solv, &q) == 0);
+  policy_findupdatepackages(solv, pool->solvables + oa, &q, 0);
+  check(q.count == 0);
+  solver_free(solv);
+  pool->considered = 0;
+  map_free(&considered);
+  queue_free(&q);
+
+  pool_free(pool);
+  return 0;
+}
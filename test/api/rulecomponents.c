@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * rulecomponents.c
+ *
+ * check that solver_rulecomponents splits the packages into the
+ * connected components of the rules
+ */
+
+#include <string.h>
+
+#include "pool.h"
+#include "poolarch.h"
+#include "repo.h"
+#include "solver.h"
+#include "util.h"
+#include "testutil.h"
+
+static const char *testrepo =
+  "=Pkg: a 1 1 noarch\n"
+  "=Req: b\n"
+  "=Pkg: b 1 1 noarch\n"
+  "=Req: c\n"
+  "=Pkg: c 1 1 noarch\n"
+  "=Pkg: d 1 1 noarch\n"
+  "=Con: e\n"
+  "=Pkg: e 1 1 noarch\n"
+  "=Pkg: f 1 1 noarch\n"
+  "=Pkg: g 1 1 noarch\n"
+  "=Req: a\n";
+
+static Id
+findsolvable(Pool *pool, const char *str)
+{
+  Id p;
+  for (p = 2; p < pool->nsolvables; p++)
+    if (!strcmp(pool_solvid2str(pool, p), str))
+      return p;
+  check(0);
+  return 0;
+}
+
+/* generic checks: every rule literal has a component, all literals of
+ * a rule have the same one, and every component is used by a rule */
+static void
+checkrules(Solver *solv, Queue *q, int ncomp)
+{
+  Pool *pool = solv->pool;
+  Id p, pp, comp;
+  Rule *r;
+  Map seen, used;
+  int i;
+
+  check(q->count == pool->nsolvables);
+  check(q->elements[SYSTEMSOLVABLE] == 0);
+  map_init(&seen, pool->nsolvables);
+  map_init(&used, ncomp + 1);
+  for (i = 1, r = solv->rules + i; i < solv->nrules; i++, r++)
+    {
+      Id *dp;
+      comp = 0;
+      FOR_RULELITERALS(pp, dp, r)
+	{
+	  p = pp > 0 ? pp : -pp;
+	  if (p == SYSTEMSOLVABLE)
+	    continue;
+	  check(q->elements[p] > 0 && q->elements[p] <= ncomp);
+	  if (!comp)
+	    comp = q->elements[p];
+	  check(q->elements[p] == comp);
+	  MAPSET(&seen, p);
+	}
+      if (comp)
+	MAPSET(&used, comp);
+    }
+  for (p = 2; p < pool->nsolvables; p++)
+    check(MAPTST(&seen, p) ? q->elements[p] > 0 : q->elements[p] == 0);
+  for (comp = 1; comp <= ncomp; comp++)
+    check(MAPTST(&used, comp));
+  map_free(&seen);
+  map_free(&used);
+}
+
+int
+main(void)
+{
+  Pool *pool = pool_create();
+  Solver *solv;
+  Queue job, q;
+  Id a, b, c, d, e, f, g;
+  int ncomp;
+
+  pool_setarch(pool, "x86_64");
+  testutil_addrepo(pool, "test", testrepo, 0);
+  pool_addfileprovides(pool);
+  pool_createwhatprovides(pool);
+  a = findsolvable(pool, "a-1-1.noarch");
+  b = findsolvable(pool, "b-1-1.noarch");
+  c = findsolvable(pool, "c-1-1.noarch");
+  d = findsolvable(pool, "d-1-1.noarch");
+  e = findsolvable(pool, "e-1-1.noarch");
+  f = findsolvable(pool, "f-1-1.noarch");
+  g = findsolvable(pool, "g-1-1.noarch");
+
+  queue_init(&job);
+  queue_init(&q);
+  queue_push2(&job, SOLVER_INSTALL | SOLVER_SOLVABLE, a);
+  queue_push2(&job, SOLVER_INSTALL | SOLVER_SOLVABLE, d);
+  queue_push2(&job, SOLVER_INSTALL | SOLVER_SOLVABLE, f);
+  solv = solver_create(pool);
+  check(solver_solve(solv, &job) == 0);
+  ncomp = solver_rulecomponents(solv, &q);
+  checkrules(solv, &q, ncomp);
+
+  /* {a, b, c}, {d, e} and {f}, g is not part of any rule */
+  check(ncomp == 3);
+  check(q.elements[a] && q.elements[a] == q.elements[b] && q.elements[a] == q.elements[c]);
+  check(q.elements[d] && q.elements[d] == q.elements[e]);
+  check(q.elements[f]);
+  check(q.elements[a] != q.elements[d] && q.elements[a] != q.elements[f] && q.elements[d] != q.elements[f]);
+  check(q.elements[g] == 0);
+  solver_free(solv);
+
+  /* installing g joins its component with the one of a */
+  queue_push2(&job, SOLVER_INSTALL | SOLVER_SOLVABLE, g);
+  solv = solver_create(pool);
+  check(solver_solve(solv, &job) == 0);
+  ncomp = solver_rulecomponents(solv, &q);
+  checkrules(solv, &q, ncomp);
+  check(ncomp == 3);
+  check(q.elements[g] && q.elements[g] == q.elements[a]);
+  solver_free(solv);
+
+  queue_free(&job);
+  queue_free(&q);
+  pool_free(pool);
+  return 0;
+}
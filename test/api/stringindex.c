@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * stringindex.c
+ *
+ * check that string searches find the same solvables with and
+ * without the trigram string index
+ */
+
+#include <string.h>
+
+#include "pool.h"
+#include "repo.h"
+#include "repodata.h"
+#include "util.h"
+#include "testutil.h"
+
+#define NPKGS	300
+
+static const char *words[] = { "Alpha", "beta", "gamma", "DELTA", "libfoo", "foobar", "xy", "a.b", "Foo-Bar" };
+#define NWORDS	(int)(sizeof(words) / sizeof(*words))
+
+static struct {
+  const char *match;
+  int flags;
+} searches[] = {
+  { "foo", SEARCH_SUBSTRING },
+  { "foo", SEARCH_SUBSTRING | SEARCH_NOCASE },
+  { "FOO", SEARCH_SUBSTRING },
+  { "ta g", SEARCH_SUBSTRING },
+  { "ta gamma al", SEARCH_SUBSTRING | SEARCH_NOCASE },
+  { "xy", SEARCH_SUBSTRING },
+  { "beta", SEARCH_STRING },
+  { "beta gamma", SEARCH_STRING },
+  { "ALPHA BETA", SEARCH_STRING | SEARCH_NOCASE },
+  { "alp", SEARCH_STRINGSTART },
+  { "alp", SEARCH_STRINGSTART | SEARCH_NOCASE },
+  { "bar", SEARCH_STRINGEND },
+  { "BAR", SEARCH_STRINGEND | SEARCH_NOCASE },
+  { "*foo*bar*", SEARCH_GLOB },
+  { "*libfoo ??", SEARCH_GLOB },
+  { "al?ha*", SEARCH_GLOB | SEARCH_NOCASE },
+  { "[ab]*", SEARCH_GLOB },
+  { "*", SEARCH_GLOB },
+  { "^be.a", SEARCH_REGEX },
+  { "a\\.b$", SEARCH_REGEX },
+  { 0, 0 }
+};
+
+static void
+search(Pool *pool, Repo *repo, const char *match, int flags, Queue *q)
+{
+  Dataiterator di;
+
+  queue_empty(q);
+  dataiterator_init(&di, pool, repo, 0, SOLVABLE_SUMMARY, match, flags);
+  while (dataiterator_step(&di))
+    {
+      queue_push(q, di.solvid);
+      dataiterator_skip_solvable(&di);
+    }
+  dataiterator_free(&di);
+}
+
+/* search the summaries in the sub-structures of the array key */
+static void
+search_sub(Pool *pool, Repo *repo, Id subkey, const char *match, int flags, Queue *q)
+{
+  Dataiterator di;
+
+  queue_empty(q);
+  dataiterator_init(&di, pool, repo, 0, subkey, match, flags | SEARCH_SUB);
+  while (dataiterator_step(&di))
+    if (di.kv.parent && di.key->name == SOLVABLE_SUMMARY)
+      queue_push(q, di.solvid);
+  dataiterator_free(&di);
+}
+
+int
+main(void)
+{
+  Pool *pool = pool_create();
+  Repo *repo;
+  Repodata *data;
+  Id subkey, h;
+  Queue q1, q2;
+  char *str = 0, buf[64];
+  unsigned int seed = 42;
+  int i, j, n, total = 0;
+
+  for (i = 0; i < NPKGS; i++)
+    {
+      sprintf(buf, "=Pkg: p%d 1 1 noarch\n=Sum:", i);
+      str = solv_dupappend(str, buf, 0);
+      seed = seed * 1103515245 + 12345;
+      n = 1 + (seed >> 16) % 4;
+      for (j = 0; j < n; j++)
+	{
+	  seed = seed * 1103515245 + 12345;
+	  str = solv_dupappend(str, " ", words[(seed >> 16) % NWORDS]);
+	}
+      str = solv_dupappend(str, "\n", 0);
+    }
+  repo = testutil_addrepo(pool, "test", str, 0);
+  solv_free(str);
+  check(repo->nsolvables == NPKGS);
+  data = repo_last_repodata(repo);
+
+  /* also put summaries into an array of sub-structures */
+  subkey = pool_str2id(pool, "test:sub", 1);
+  for (i = 0; i < NPKGS; i += 3)
+    {
+      seed = seed * 1103515245 + 12345;
+      h = repodata_new_handle(data);
+      repodata_set_str(data, h, SOLVABLE_SUMMARY, words[(seed >> 16) % NWORDS]);
+      repodata_add_flexarray(data, repo->start + i, subkey, h);
+    }
+  repodata_internalize(data);
+
+  queue_init(&q1);
+  queue_init(&q2);
+  /* run every search twice to also check the cached candidates */
+  for (j = 0; j < 2; j++)
+    for (i = 0; searches[i].match; i++)
+      {
+	repodata_free_stringindex(data);
+	search(pool, repo, searches[i].match, searches[i].flags, &q1);
+	repodata_create_stringindex(data, SOLVABLE_SUMMARY);
+	check(data->stringindex != 0);
+	search(pool, repo, searches[i].match, searches[i].flags, &q2);
+	check(q1.count == q2.count);
+	for (n = 0; n < q1.count; n++)
+	  check(q1.elements[n] == q2.elements[n]);
+	total += q1.count;
+      }
+  /* make sure that the searches are not all empty */
+  check(total > NPKGS);
+
+  /* no index for array keys, and SEARCH_SUB searches still find
+   * the nested strings */
+  repodata_free_stringindex(data);
+  repodata_create_stringindex(data, subkey);
+  check(data->stringindex == 0);
+  total = 0;
+  for (i = 0; searches[i].match; i++)
+    {
+      repodata_free_stringindex(data);
+      search_sub(pool, repo, subkey, searches[i].match, searches[i].flags, &q1);
+      repodata_create_stringindex(data, SOLVABLE_SUMMARY);
+      repodata_create_stringindex(data, subkey);
+      search_sub(pool, repo, subkey, searches[i].match, searches[i].flags, &q2);
+      check(q1.count == q2.count);
+      for (n = 0; n < q1.count; n++)
+	check(q1.elements[n] == q2.elements[n]);
+      total += q1.count;
+    }
+  check(total > 0);
+
+  /* the index is dropped if the data changes */
+  repodata_set_str(data, repo->start, SOLVABLE_SUMMARY, "changed");
+  repodata_internalize(data);
+  check(data->stringindex == 0);
+
+  queue_free(&q1);
+  queue_free(&q2);
+  pool_free(pool);
+  return 0;
+}
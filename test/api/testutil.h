@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * testutil.h
+ *
+ * small helpers for the api tests
+ */
+
+#ifndef TESTUTIL_H
+#define TESTUTIL_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pool.h"
+#include "repo.h"
+#include "testcase.h"
+
+#define check(x) do {							\
+    if (!(x))								\
+      {									\
+	fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x);	\
+	exit(1);							\
+      }									\
+  } while (0)
+
+/* add a repo from a string in testtags format */
+static inline Repo *
+testutil_addrepo(Pool *pool, const char *name, const char *testtags, int flags)
+{
+  Repo *repo = repo_create(pool, name);
+  FILE *fp = tmpfile();
+
+  check(fp != 0);
+  fputs(testtags, fp);
+  rewind(fp);
+  testcase_add_susetags(repo, fp, flags);
+  fclose(fp);
+  return repo;
+}
+
+#endif
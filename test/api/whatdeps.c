@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2026, SUSE LLC
+ *
+ * This program is licensed under the BSD license, read LICENSE.BSD
+ * for further information
+ */
+
+/*
+ * whatdeps.c
+ *
+ * check pool_whatdeps_ptr and pool_whatmatchesdep against a
+ * search over all solvables
+ */
+
+#include <string.h>
+
+#include "pool.h"
+#include "poolarch.h"
+#include "repo.h"
+#include "util.h"
+#include "testutil.h"
+
+static const char *systemrepo =
+  "=Pkg: a 1 1 x86_64\n"
+  "=Req: b > 1\n"
+  "=Rec: c\n"
+  "=Pkg: b 1 1 x86_64\n"
+  "=Req: c | d\n"
+  "=Sup: a\n";
+
+static const char *testrepo =
+  "=Pkg: a 2 1 x86_64\n"
+  "=Req: b >= 2\n"
+  "=Req: b\n"
+  "=Req: libfoo.so.1\n"
+  "=Prq: d\n"
+  "=Enh: b\n"
+  "=Pkg: b 2 1 x86_64\n"
+  "=Req: c.x86_64\n"
+  "=Rec: d < 2\n"
+  "=Pkg: c 1 1 noarch\n"
+  "=Sup: a | b\n"
+  "=Prv: libfoo.so.1\n"
+  "=Pkg: d 1 1 x86_64\n"
+  "=Req: a = 2-1\n"
+  "=Req: e\n"
+  "=Enh: c\n"
+  "=Pkg: d 2 1 x86_64\n"
+  "=Req: a = 1-1\n"
+  "=Sup: d\n"
+  "=Pkg: e 1 1 ppc\n"
+  "=Req: a\n"
+  "=Rec: c\n";
+
+static Id keynames[] = { SOLVABLE_REQUIRES, SOLVABLE_RECOMMENDS, SOLVABLE_SUPPLEMENTS, SOLVABLE_ENHANCES };
+
+static Offset
+solvable_deps(Solvable *s, Id keyname)
+{
+  switch (keyname)
+    {
+    case SOLVABLE_REQUIRES:
+      return s->requires;
+    case SOLVABLE_RECOMMENDS:
+      return s->recommends;
+    case SOLVABLE_SUPPLEMENTS:
+      return s->supplements;
+    default:
+      return s->enhances;
+    }
+}
+
+/* does dep mention name? */
+static int
+dep_has_name(Pool *pool, Id dep, Id name)
+{
+  while (ISRELDEP(dep))
+    {
+      Reldep *rd = GETRELDEP(pool, dep);
+      if (rd->flags == REL_OR || rd->flags == REL_AND || rd->flags == REL_WITH)
+	{
+	  if (dep_has_name(pool, rd->name, name))
+	    return 1;
+	  dep = rd->evr;
+	}
+      else
+	dep = rd->name;
+    }
+  return dep == name;
+}
+
+static int
+dep_matches(Pool *pool, Id dep, Id d)
+{
+  while (ISRELDEP(d))
+    {
+      Reldep *rd = GETRELDEP(pool, d);
+      if (rd->flags != REL_OR && rd->flags != REL_AND && rd->flags != REL_WITH)
+	break;
+      if (dep_matches(pool, dep, rd->name))
+	return 1;
+      d = rd->evr;
+    }
+  return pool_match_dep(pool, dep, d);
+}
+
+/* the solvables the index looks at */
+static int
+considered(Pool *pool, Solvable *s)
+{
+  if (!s->repo || s->repo->disabled)
+    return 0;
+  return s->repo == pool->installed || pool_installable(pool, s);
+}
+
+static void
+checkname(Pool *pool, Id keyname, Id name)
+{
+  Id p, *pp, *dp;
+  Solvable *s;
+  Queue q;
+  int i;
+
+  queue_init(&q);
+  for (p = 2; p < pool->nsolvables; p++)
+    {
+      s = pool->solvables + p;
+      if (!considered(pool, s) || !solvable_deps(s, keyname))
+	continue;
+      for (dp = s->repo->idarraydata + solvable_deps(s, keyname); *dp; dp++)
+	if (*dp != SOLVABLE_PREREQMARKER && dep_has_name(pool, *dp, name))
+	  break;
+      if (*dp)
+	queue_push(&q, p);
+    }
+  pp = pool_whatdeps_ptr(pool, keyname, name);
+  for (i = 0; i < q.count; i++)
+    check(pp[i] == q.elements[i]);
+  check(pp[i] == 0);
+  queue_free(&q);
+}
+
+static void
+checkdep(Pool *pool, Id keyname, Id dep)
+{
+  Id p, *dp;
+  Solvable *s;
+  Queue q, q2;
+  int i;
+
+  queue_init(&q);
+  queue_init(&q2);
+  for (p = 2; p < pool->nsolvables; p++)
+    {
+      s = pool->solvables + p;
+      if (!considered(pool, s) || !solvable_deps(s, keyname))
+	continue;
+      for (dp = s->repo->idarraydata + solvable_deps(s, keyname); *dp; dp++)
+	if (*dp != SOLVABLE_PREREQMARKER && dep_matches(pool, dep, *dp))
+	  break;
+      if (*dp)
+	queue_push(&q, p);
+    }
+  pool_whatmatchesdep(pool, keyname, dep, &q2);
+  check(q.count == q2.count);
+  for (i = 0; i < q.count; i++)
+    check(q.elements[i] == q2.elements[i]);
+  queue_free(&q);
+  queue_free(&q2);
+}
+
+int
+main(void)
+{
+  Pool *pool = pool_create();
+  Repo *system, *repo;
+  Id name, p, *pp;
+  Queue q;
+  int k;
+
+  pool_setarch(pool, "x86_64");
+  system = testutil_addrepo(pool, "system", systemrepo, 0);
+  repo = testutil_addrepo(pool, "test", testrepo, 0);
+  pool_set_installed(pool, system);
+  pool_addfileprovides(pool);
+  pool_createwhatprovides(pool);
+
+  for (k = 0; k < 4; k++)
+    for (name = 1; name < pool->ss.nstrings; name++)
+      checkname(pool, keynames[k], name);
+
+  /* match against all provides, and against some versioned deps */
+  queue_init(&q);
+  for (k = 0; k < 4; k++)
+    {
+      for (p = 2; p < pool->nsolvables; p++)
+	{
+	  Solvable *s = pool->solvables + p;
+	  if (!s->provides)
+	    continue;
+	  for (pp = s->repo->idarraydata + s->provides; *pp; pp++)
+	    checkdep(pool, keynames[k], *pp);
+	}
+      for (name = 1; name < pool->ss.nstrings; name++)
+	checkdep(pool, keynames[k], name);
+    }
+  /* e-1-1 also requires a, but is not installable */
+  pool_whatmatchesdep(pool, SOLVABLE_REQUIRES, testcase_str2dep(pool, "a = 2-1"), &q);
+  check(q.count == 1 && !strcmp(pool_solvid2str(pool, q.elements[0]), "d-1-1.x86_64"));
+  pool_whatmatchesdep(pool, SOLVABLE_REQUIRES, pool_str2id(pool, "a", 0), &q);
+  check(q.count == 2);
+  queue_free(&q);
+
+  /* unsupported keynames and names created after the index give empty lists */
+  check(*pool_whatdeps_ptr(pool, SOLVABLE_CONFLICTS, pool_str2id(pool, "a", 0)) == 0);
+  name = pool_str2id(pool, "newname", 1);
+  check(*pool_whatdeps_ptr(pool, SOLVABLE_REQUIRES, name) == 0);
+
+  /* the index is rebuilt after pool_createwhatprovides */
+  repo_free(repo, 1);
+  pool_createwhatprovides(pool);
+  check(pool->whatdeps[0] == 0);
+  for (k = 0; k < 4; k++)
+    for (name = 1; name < pool->ss.nstrings; name++)
+      checkname(pool, keynames[k], name);
+
+  pool_free(pool);
+  return 0;
+}
@@ -0,0 +1,9 @@
+repo system 0 empty
+repo test 0 susetags activity-packages.repo
+system x86_64 rpm system
+solverflags activityheuristic
+job install name e
+result transaction,problems <inline>
+#>install e-1-1.noarch@test
+#>install q-2-1.noarch@test
+#>install x-1-1.noarch@test
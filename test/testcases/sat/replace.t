@@ -0,0 +1,12 @@
+repo system 0 susetags replace-system.repo
+repo test 0 susetags replace-packages.repo
+system x86_64 rpm system
+job install name H
+job install pkg H-3-1.x86_64@test
+result transaction,problems <inline>
+#>downgrade D-3-1.noarch@system D-2-1.x86_64@test
+#>install H-3-1.x86_64@test
+#>problem 8c9d1734 info package H-3-1.x86_64 requires D = 2, but none of the providers can be installed
+#>problem 8c9d1734 solution 5cbd134a replace D-3-1.noarch@system D-2-1.x86_64@test
+#>problem 8c9d1734 solution ff0d210a deljob install name H
+#>problem 8c9d1734 solution ff0d210a deljob install pkg H-3-1.x86_64@test
@@ -158,6 +158,7 @@ dump_repoattrs(Repo *repo, Id p)
   dataiterator_init(&di, repo->pool, repo, p, 0, 0, SEARCH_ARRAYSENTINEL|SEARCH_SUB);
   while (dataiterator_step(&di))
     dump_attr(repo, di.data, di.key, &di.kv);
+  dataiterator_free(&di);
 #endif
 }
 
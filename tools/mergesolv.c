@@ -21,14 +21,16 @@
 
 #include "pool.h"
 #include "repo_solv.h"
+#include "chksum.h"
 #include "common_write.h"
 
 static void
 usage()
 {
   fprintf(stderr, "\nUsage:\n"
-	  "mergesolv [file] [file] [...]\n"
+	  "mergesolv [-d] [file] [file] [...]\n"
 	  "  merges multiple solv files into one and writes it to stdout\n"
+	  "  -d: drop duplicate packages (same name, evr, arch and checksum)\n"
 	  );
   exit(0);
 }
@@ -54,6 +56,58 @@ loadcallback (Pool *pool, Repodata *data, void *vdata)
   return r ? 0 : 1;
 }
 
+static int
+same_solvable(Solvable *s, Solvable *s2)
+{
+  const unsigned char *chk, *chk2;
+  Id type, type2;
+
+  if (s->name != s2->name || s->evr != s2->evr || s->arch != s2->arch)
+    return 0;
+  chk = solvable_lookup_bin_checksum(s, SOLVABLE_CHECKSUM, &type);
+  chk2 = solvable_lookup_bin_checksum(s2, SOLVABLE_CHECKSUM, &type2);
+  if (!chk || !chk2)
+    return !chk && !chk2;
+  return type == type2 && !memcmp(chk, chk2, solv_chksum_len(type));
+}
+
+/* free all solvables that are the same as an earlier one */
+static void
+drop_duplicates(Repo *repo)
+{
+  Pool *pool = repo->pool;
+  Hashtable ht;
+  Hashmask hm;
+  Hashval h, hh;
+  Solvable *s;
+  Id p, p2;
+  int ndropped = 0;
+
+  hm = mkmask(repo->nsolvables);
+  ht = solv_calloc(hm + 1, sizeof(Id));
+  FOR_REPO_SOLVABLES(repo, p, s)
+    {
+      h = relhash(s->name, s->evr, s->arch) & hm;
+      hh = HASHCHAIN_START;
+      while ((p2 = ht[h]) != 0)
+	{
+	  if (same_solvable(s, pool->solvables + p2))
+	    break;
+	  h = HASHCHAIN_NEXT(h, hh, hm);
+	}
+      if (p2)
+	{
+	  repo_free_solvable(repo, p, 0);
+	  ndropped++;
+	  continue;
+	}
+      ht[h] = p;
+    }
+  solv_free(ht);
+  if (ndropped)
+    fprintf(stderr, "dropped %d duplicate packages\n", ndropped);
+}
+
 int
 main(int argc, char **argv)
 {
@@ -61,12 +115,13 @@ main(int argc, char **argv)
   Repo *repo;
   const char *basefile = 0;
   int with_attr = 0;
+  int dedup = 0;
   int c;
 
   pool = pool_create();
   repo = repo_create(pool, "<mergesolv>");
   
-  while ((c = getopt(argc, argv, "ahb:")) >= 0)
+  while ((c = getopt(argc, argv, "adhb:")) >= 0)
     {
       switch (c)
       {
@@ -79,6 +134,9 @@ main(int argc, char **argv)
 	case 'b':
 	  basefile = optarg;
 	  break;
+	case 'd':
+	  dedup = 1;
+	  break;
 	default:
 	  exit(1);
       }
@@ -97,6 +155,8 @@ main(int argc, char **argv)
       repo_add_solv(repo, fp, 0);
       fclose(fp);
     }
+  if (dedup)
+    drop_duplicates(repo);
   tool_write(repo, basefile, 0);
   pool_free(pool);
   return 0;